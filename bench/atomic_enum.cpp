@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/atomic_enum.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Threads sharing one state enum, mostly reading it and sometimes moving it on,
+// through AtomicEnum (with a compare and swap loop) against an EnumT behind a std::mutex.
+// Results are time per operation across all threads.
+
+#include "atomic_enum.hpp"
+#include "enum.hpp"
+
+#include "bench.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int operations = 400000;
+
+struct Idle {};
+
+struct Running {
+    int progress;
+};
+
+struct Failed {
+    short code;
+};
+
+// Twice the size, so it takes a 16 byte word
+struct Progress {
+    std::int64_t done;
+};
+
+template<typename... Ts>
+struct Locked {
+    using Enum = venum::EnumT<Ts...>;
+
+    explicit Locked(const Enum& e) : state(e) {}
+
+    Enum load() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return state;
+    }
+
+    template<typename F>
+    void update(F f) {
+        std::lock_guard<std::mutex> lock(mutex);
+        state = f(state);
+    }
+
+    std::mutex mutex;
+    Enum state;
+};
+
+template<typename... Ts, typename F>
+void update(venum::AtomicEnum<Ts...>& shared, F f) {
+    auto current = shared.load();
+    while(!shared.compare_exchange_weak(current, f(current))) {}
+}
+
+template<typename... Ts, typename F>
+void update(Locked<Ts...>& shared, F f) {
+    shared.update(f);
+}
+
+// Every eighth operation moves Running on by one, the rest read it
+template<typename Shared, typename Next>
+void run(const std::string& name, int threads, Next next) {
+    double ns = bench::measure(static_cast<std::size_t>(threads) * operations, [&]() {
+        Shared shared(typename Shared::Enum(Running{ 0 }));
+
+        std::vector<std::thread> workers;
+        for(int t = 0; t < threads; ++t) {
+            workers.emplace_back([&shared, &next]() {
+                std::size_t running = 0;
+
+                for(int i = 0; i < operations; ++i) {
+                    if(i % 8 == 0) {
+                        update(shared, next);
+                    } else {
+                        running += shared.load().template contains<Running>() ? 1 : 0;
+                    }
+                }
+
+                bench::do_not_optimize(running);
+            });
+        }
+
+        for(auto& worker : workers) {
+            worker.join();
+        }
+    }, 3);
+
+    bench::report(name + "/threads=" + std::to_string(threads), ns);
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    using State = venum::EnumT<Idle, Running, Failed>;
+    using Wide = venum::EnumT<Idle, Running, Progress>;
+
+    auto next = [](const State& s) { return State(Running{ s.get<Running>().progress + 1 }); };
+    auto next_wide = [](const Wide& s) { return Wide(Running{ s.get<Running>().progress + 1 }); };
+
+    for(int threads : { 1, 2, 4, 8 }) {
+        run<venum::AtomicEnum<Idle, Running, Failed>>("atomic 8 byte", threads, next);
+        run<Locked<Idle, Running, Failed>>("mutex 8 byte", threads, next);
+        run<venum::AtomicEnum<Idle, Running, Progress>>("atomic 16 byte", threads, next_wide);
+        run<Locked<Idle, Running, Progress>>("mutex 16 byte", threads, next_wide);
+    }
+}
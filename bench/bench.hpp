@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/bench.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_BENCH_HPP
+#define ENUM_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace bench {
+
+// Stops the compiler from optimising away a value
+template<typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// How report prints results
+enum class Format {
+    Text,
+    Csv
+};
+
+inline Format& format() {
+    static Format format = Format::Text;
+    return format;
+}
+
+// Reads options from the command line. --csv prints a header and then
+// one "benchmark,ns_per_op" line per result, for comparing between runs
+inline void init(int argc, char* argv[]) {
+    for(int i = 1; i < argc; ++i) {
+        if(std::string(argv[i]) == "--csv") {
+            format() = Format::Csv;
+        }
+    }
+
+    if(format() == Format::Csv) {
+        std::cout << "benchmark,ns_per_op" << std::endl;
+    }
+}
+
+// Runs f (which performs `ops` operations) a few times and returns the best
+// time per operation in nanoseconds
+template<typename F>
+double measure(std::size_t ops, F f, std::size_t runs = 5) {
+    double best = 0;
+
+    for(std::size_t i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / ops;
+        best = (i == 0) ? ns : std::min(best, ns);
+    }
+
+    return best;
+}
+
+// Prints a single result line
+inline void report(const std::string& name, double ns) {
+    if(format() == Format::Csv) {
+        std::cout << name << ',' << std::fixed << std::setprecision(3) << ns << std::endl;
+        return;
+    }
+
+    std::cout << std::left << std::setw(48) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(3) << ns
+              << " ns/op" << std::endl;
+}
+
+// Prints a result for operations that each process `bytes` bytes, adding the throughput
+// in MB/s to the text output (CSV lines stay in ns per operation)
+inline void report(const std::string& name, double ns, double bytes) {
+    if(format() == Format::Csv) {
+        report(name, ns);
+        return;
+    }
+
+    std::cout << std::left << std::setw(48) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(3) << ns
+              << " ns/op" << std::setw(12) << std::setprecision(1) << bytes * 1000 / ns << " MB/s" << std::endl;
+}
+
+}
+
+#endif
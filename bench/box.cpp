@@ -0,0 +1,160 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/box.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Builds, walks and frees an expression tree of 10^6 nodes, with the recursive
+// variants boxed against held through std::shared_ptr, and walks a vector of
+// messages with one large rare variant stored inline against boxed.
+
+#include "box.hpp"
+#include "enum.hpp"
+
+#include "bench.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr std::size_t nodes = 1000000;
+
+// Fewer, since inline each is the size of the large variant
+constexpr std::size_t message_count = 100000;
+
+namespace boxed {
+    struct Add;
+    struct Mul;
+
+    using Expr = venum::EnumT<double, venum::Box<Add>, venum::Box<Mul>>;
+
+    struct Add {
+        Expr lhs, rhs;
+    };
+
+    struct Mul {
+        Expr lhs, rhs;
+    };
+
+    // A balanced tree of about n nodes, alternating Add and Mul by level
+    Expr build(std::size_t n, bool add = true) {
+        if(n < 3) {
+            return Expr(1.0);
+        }
+
+        std::size_t lhs = (n - 1) / 2;
+        Expr l = build(lhs, !add);
+        Expr r = build(n - 1 - lhs, !add);
+
+        return add ? Expr(Add{ std::move(l), std::move(r) }) : Expr(Mul{ std::move(l), std::move(r) });
+    }
+
+    double evaluate(const Expr& e) {
+        return e.match(
+            [](double d) { return d; },
+            [](const Add& a) { return evaluate(a.lhs) + evaluate(a.rhs); },
+            [](const Mul& m) { return evaluate(m.lhs) * evaluate(m.rhs); }
+        );
+    }
+}
+
+namespace shared {
+    struct Add;
+    struct Mul;
+
+    using Expr = venum::EnumT<double, std::shared_ptr<const Add>, std::shared_ptr<const Mul>>;
+
+    struct Add {
+        Expr lhs, rhs;
+    };
+
+    struct Mul {
+        Expr lhs, rhs;
+    };
+
+    Expr build(std::size_t n, bool add = true) {
+        if(n < 3) {
+            return Expr(1.0);
+        }
+
+        std::size_t lhs = (n - 1) / 2;
+        Expr l = build(lhs, !add);
+        Expr r = build(n - 1 - lhs, !add);
+
+        return add
+            ? Expr(std::make_shared<const Add>(Add{ std::move(l), std::move(r) }))
+            : Expr(std::make_shared<const Mul>(Mul{ std::move(l), std::move(r) }));
+    }
+
+    double evaluate(const Expr& e) {
+        return e.match(
+            [](double d) { return d; },
+            [](const std::shared_ptr<const Add>& a) { return evaluate(a->lhs) + evaluate(a->rhs); },
+            [](const std::shared_ptr<const Mul>& m) { return evaluate(m->lhs) * evaluate(m->rhs); }
+        );
+    }
+}
+
+template<typename Expr, typename Build, typename Evaluate>
+void expression(const std::string& name, Build build, Evaluate evaluate) {
+    bench::report("build and free/" + name, bench::measure(nodes, [&]() {
+        Expr e = build(nodes, true);
+        bench::do_not_optimize(e);
+    }));
+
+    Expr e = build(nodes, true);
+
+    bench::report("walk/" + name, bench::measure(nodes, [&]() {
+        bench::do_not_optimize(evaluate(e));
+    }));
+}
+
+struct Large {
+    char bytes[512];
+};
+
+// Mostly small messages, with a large one every thousand
+template<typename Message>
+void messages(const std::string& name) {
+    std::vector<Message> values;
+    values.reserve(message_count);
+
+    for(std::size_t i = 0; i < message_count; ++i) {
+        if(i % 1000 == 0) {
+            values.emplace_back(Large{ { 1 } });
+        } else {
+            values.emplace_back(static_cast<int>(i));
+        }
+    }
+
+    bench::report("walk messages/" + name + "/" + std::to_string(sizeof(Message)) + " bytes each", bench::measure(message_count, [&]() {
+        long sum = 0;
+        for(auto& m : values) {
+            sum += m.match([](int i) { return i; }, [](const Large& l) { return int(l.bytes[0]); });
+        }
+
+        bench::do_not_optimize(sum);
+    }));
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    expression<boxed::Expr>("box", boxed::build, boxed::evaluate);
+    expression<shared::Expr>("shared_ptr", shared::build, shared::evaluate);
+
+    messages<venum::EnumT<int, Large>>("inline");
+    messages<venum::EnumT<int, venum::Box<Large>>>("boxed");
+}
@@ -0,0 +1,301 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/compare.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Compares venum::EnumT against std::variant, and against a hand-written
+// tagged union as the floor, for each basic operation across alternative
+// counts and payload sizes. Needs C++17 for std::variant.
+// Trivially copyable payloads make copying, moving and assigning a memcpy for
+// both, so the string payload is there to compare their dispatch on those.
+// The tagged union holds every alternative as the same struct, so it never
+// dispatches, and is named tagged-no-dispatch.
+//
+// Results are named <implementation>/<operation>/n=<alternatives>/size=<bytes or string>,
+// run with --csv to get one comma separated line per result.
+
+#include "enum.hpp"
+
+#include "bench.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+template<std::size_t n, std::size_t size>
+struct Alt {
+    std::uint32_t value;
+    unsigned char padding[size - sizeof(std::uint32_t)];
+};
+
+// Size standing for a payload with a std::string, which isn't trivially copyable
+constexpr std::size_t text = 0;
+
+template<std::size_t n>
+struct Alt<n, text> {
+    std::uint32_t value;
+    std::string text;
+};
+
+// Gives each alternative a different result, so the dispatch can't be folded
+template<std::size_t n, std::size_t size>
+struct Handler {
+    std::uint32_t operator()(const Alt<n, size>& a) const {
+        return a.value + n;
+    }
+};
+
+template<typename... Fs>
+struct Overload : Fs... {
+    using Fs::operator()...;
+};
+
+template<typename... Fs>
+Overload(Fs...) -> Overload<Fs...>;
+
+// Every implementation provides the same operations, with alternatives
+// picked by index
+
+template<std::size_t size, typename>
+struct VenumImpl;
+
+template<std::size_t size, std::size_t... ns>
+struct VenumImpl<size, std::index_sequence<ns...>> {
+    using type = venum::EnumT<Alt<ns, size>...>;
+
+    static constexpr const char* name = "venum";
+
+    template<std::size_t n>
+    static type make(std::uint32_t value) {
+        return type::template construct<Alt<n, size>>(Alt<n, size>{value});
+    }
+
+    static std::uint32_t match(const type& e) {
+        return e.match(Handler<ns, size>{}...);
+    }
+
+    static std::uint32_t apply(const type& e) {
+        return e.apply([](const auto& a) { return a.value; });
+    }
+
+    template<std::size_t n>
+    static std::uint32_t get(const type& e) {
+        return e.template get<Alt<n, size>>().value;
+    }
+};
+
+template<std::size_t size, typename>
+struct StdImpl;
+
+template<std::size_t size, std::size_t... ns>
+struct StdImpl<size, std::index_sequence<ns...>> {
+    using type = std::variant<Alt<ns, size>...>;
+
+    static constexpr const char* name = "std";
+
+    template<std::size_t n>
+    static type make(std::uint32_t value) {
+        return type(std::in_place_index<n>, Alt<n, size>{value});
+    }
+
+    static std::uint32_t match(const type& e) {
+        return std::visit(Overload{Handler<ns, size>{}...}, e);
+    }
+
+    static std::uint32_t apply(const type& e) {
+        return std::visit([](const auto& a) { return a.value; }, e);
+    }
+
+    template<std::size_t n>
+    static std::uint32_t get(const type& e) {
+        return std::get<n>(e).value;
+    }
+};
+
+// What you would write by hand: a tag next to the payload. Every alternative
+// has the same layout here, so the union collapses to a single member.
+template<std::size_t size, typename>
+struct RawImpl;
+
+template<std::size_t size, std::size_t... ns>
+struct RawImpl<size, std::index_sequence<ns...>> {
+    struct type {
+        std::uint32_t tag;
+        Alt<0, size> payload;
+    };
+
+    static constexpr const char* name = "tagged-no-dispatch";
+
+    template<std::size_t n>
+    static type make(std::uint32_t value) {
+        return type{n, Alt<0, size>{value}};
+    }
+
+    static std::uint32_t match(const type& e) {
+        return e.payload.value + e.tag;
+    }
+
+    static std::uint32_t apply(const type& e) {
+        return e.payload.value;
+    }
+
+    template<std::size_t n>
+    static std::uint32_t get(const type& e) {
+        if(e.tag != n) {
+            throw std::runtime_error("wrong alternative");
+        }
+
+        return e.payload.value;
+    }
+};
+
+constexpr std::size_t count = 4096;
+constexpr std::size_t rounds = 64;
+
+template<typename Impl, std::size_t... ns>
+std::vector<typename Impl::type> make_values(std::size_t offset, std::index_sequence<ns...>) {
+    using Make = typename Impl::type(*)(std::uint32_t);
+    static constexpr Make makers[] = { &Impl::template make<ns>... };
+
+    std::vector<typename Impl::type> values;
+    values.reserve(count);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        values.push_back(makers[(i + offset) % sizeof...(ns)](static_cast<std::uint32_t>(i)));
+    }
+
+    return values;
+}
+
+template<template<std::size_t, typename> class ImplT, std::size_t n, std::size_t size>
+void run() {
+    using Indices = std::make_index_sequence<n>;
+    using Impl = ImplT<size, Indices>;
+    using T = typename Impl::type;
+
+    const std::string prefix = std::string(Impl::name) + "/";
+    const std::string suffix = "/n=" + std::to_string(n) + "/size=" + (size == text ? "string" : std::to_string(size));
+
+    // Mixed alternatives, and the same again shifted by one so every
+    // assignment between them changes alternative
+    std::vector<T> values = make_values<Impl>(0, Indices());
+    std::vector<T> shifted = make_values<Impl>(1, Indices());
+    std::vector<T> last(count, Impl::template make<n - 1>(1));
+
+    bench::report(prefix + "construct" + suffix, bench::measure(count * rounds, []() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            for(std::size_t i = 0; i < count; ++i) {
+                T e = Impl::template make<n - 1>(static_cast<std::uint32_t>(i));
+                bench::do_not_optimize(e);
+            }
+        }
+    }));
+
+    bench::report(prefix + "copy" + suffix, bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            for(auto& v : values) {
+                T e(v);
+                bench::do_not_optimize(e);
+            }
+        }
+    }));
+
+    bench::report(prefix + "move" + suffix, bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            for(auto& v : values) {
+                T e(std::move(v));
+                bench::do_not_optimize(e);
+            }
+        }
+    }));
+
+    std::vector<T> target = values;
+
+    bench::report(prefix + "assign same" + suffix, bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            for(std::size_t i = 0; i < count; ++i) {
+                target[i] = values[i];
+            }
+            bench::do_not_optimize(target.data());
+        }
+    }));
+
+    bench::report(prefix + "assign different" + suffix, bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            const std::vector<T>& from = (r % 2 == 0) ? shifted : values;
+            for(std::size_t i = 0; i < count; ++i) {
+                target[i] = from[i];
+            }
+            bench::do_not_optimize(target.data());
+        }
+    }));
+
+    bench::report(prefix + "match" + suffix, bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            std::uint32_t sum = 0;
+            for(auto& v : values) {
+                sum += Impl::match(v);
+            }
+            bench::do_not_optimize(sum);
+        }
+    }));
+
+    bench::report(prefix + "apply" + suffix, bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            std::uint32_t sum = 0;
+            for(auto& v : values) {
+                sum += Impl::apply(v);
+            }
+            bench::do_not_optimize(sum);
+        }
+    }));
+
+    bench::report(prefix + "get" + suffix, bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            std::uint32_t sum = 0;
+            for(auto& v : last) {
+                sum += Impl::template get<n - 1>(v);
+            }
+            bench::do_not_optimize(sum);
+        }
+    }));
+}
+
+template<std::size_t n, std::size_t size>
+void compare() {
+    run<RawImpl, n, size>();
+    run<VenumImpl, n, size>();
+    run<StdImpl, n, size>();
+}
+
+template<std::size_t size>
+void compare_counts() {
+    compare<2, size>();
+    compare<8, size>();
+    compare<32, size>();
+    compare<128, size>();
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    compare_counts<8>();
+    compare_counts<64>();
+    compare_counts<text>();
+}
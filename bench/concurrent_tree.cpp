@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/concurrent_tree.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Lookup throughput with 1 to 16 reader threads while one writer keeps
+// inserting and erasing, for ConcurrentTree against a Tree behind a mutex.
+// Results are time per lookup across all readers, so they fall as reads scale.
+
+#include "concurrent_tree.hpp"
+#include "tree.hpp"
+
+#include "bench.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int keys = 100000;
+constexpr int lookups = 200000;
+
+// A Tree shared the way it has to be without ConcurrentTree
+struct LockedTree {
+    bool contains(int i) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tree.contains(i);
+    }
+
+    void insert(int i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tree.insert(i);
+    }
+
+    bool erase(int i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tree.erase(i);
+    }
+
+    mutable std::mutex mutex;
+    Tree<int> tree;
+};
+
+template<typename Set>
+void run(const std::string& name, int readers) {
+    Set set;
+    for(int i = 0; i < keys; i += 2) {
+        set.insert(i);
+    }
+
+    double ns = bench::measure(static_cast<std::size_t>(readers) * lookups, [&]() {
+        std::atomic<bool> done(false);
+
+        // Moves odd keys in and out, so the readers' answers keep changing
+        std::thread writer([&]() {
+            std::mt19937 random(1);
+            while(!done) {
+                int key = static_cast<int>(random() % keys) | 1;
+                set.insert(key);
+                set.erase(key);
+            }
+        });
+
+        std::vector<std::thread> threads;
+        for(int r = 0; r < readers; ++r) {
+            threads.emplace_back([&, r]() {
+                std::mt19937 random(static_cast<unsigned>(r + 2));
+                int found = 0;
+
+                for(int i = 0; i < lookups; ++i) {
+                    found += set.contains(static_cast<int>(random() % keys)) ? 1 : 0;
+                }
+
+                bench::do_not_optimize(found);
+            });
+        }
+
+        for(auto& thread : threads) {
+            thread.join();
+        }
+
+        done = true;
+        writer.join();
+    }, 3);
+
+    bench::report("lookup with writer/" + name + "/readers=" + std::to_string(readers), ns);
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    for(int readers : { 1, 2, 4, 8, 16 }) {
+        run<ConcurrentTree<int>>("concurrent", readers);
+        run<LockedTree>("mutex", readers);
+    }
+}
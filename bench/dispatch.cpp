@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/dispatch.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Measures the cost of dispatching over a 32 variant enum, with the tags picked at
+// random from the first k alternatives, so the branch predictor can't learn them.
+// With table dispatch the cost should be flat as k grows, where an if-chain
+// gets slower the further down the chain the alternatives are.
+// The alternatives have a user-provided copy and destructor, so copying and
+// destroying dispatches too rather than becoming a memcpy.
+
+#include "enum.hpp"
+
+#include "bench.hpp"
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+template<std::size_t n>
+struct Alt {
+    int value;
+
+    Alt(int value) : value(value) {}
+    Alt(const Alt& other) : value(other.value) {}
+    ~Alt() {}
+};
+
+template<typename>
+struct MakeEnum;
+
+template<std::size_t... ns>
+struct MakeEnum<std::index_sequence<ns...>> {
+    using type = venum::EnumT<Alt<ns>...>;
+
+    template<typename F>
+    static auto match(type& e, F f) {
+        return e.match(((void)ns, f)...);
+    }
+
+    // Constructs the nth alternative, for an n only known at runtime
+    static type make(std::size_t n, int value) {
+        using Fn = type (*)(int);
+        static constexpr Fn table[] = { &make_nth<ns>... };
+        return table[n](value);
+    }
+
+    template<std::size_t n>
+    static type make_nth(int value) {
+        return type(venum::InPlaceIndex<n>(), value);
+    }
+};
+
+using Alts = std::make_index_sequence<32>;
+using Big = MakeEnum<Alts>::type;
+
+constexpr std::size_t count = 4096;
+constexpr std::size_t rounds = 256;
+
+void run(std::size_t k) {
+    std::mt19937 random(k);
+
+    std::vector<Big> values;
+    for(std::size_t i = 0; i < count; ++i) {
+        values.push_back(MakeEnum<Alts>::make(random() % k, static_cast<int>(i)));
+    }
+
+    double apply = bench::measure(count * rounds, [&values]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            int sum = 0;
+            for(auto& v : values) {
+                sum += v.apply([](auto& a) { return a.value; });
+            }
+            bench::do_not_optimize(sum);
+        }
+    });
+
+    double match = bench::measure(count * rounds, [&values]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            int sum = 0;
+            for(auto& v : values) {
+                sum += MakeEnum<Alts>::match(v, [](auto& a) { return a.value; });
+            }
+            bench::do_not_optimize(sum);
+        }
+    });
+
+    double copy = bench::measure(count * rounds / 16, [&values]() {
+        for(std::size_t r = 0; r < rounds / 16; ++r) {
+            std::vector<Big> copied(values);
+            bench::do_not_optimize(copied.data());
+        }
+    });
+
+    bench::report("apply/random of " + std::to_string(k), apply);
+    bench::report("match/random of " + std::to_string(k), match);
+    bench::report("copy+destroy/random of " + std::to_string(k), copy);
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    run(1);
+    run(8);
+    run(16);
+    run(32);
+}
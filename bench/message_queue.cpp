@@ -0,0 +1,165 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/message_queue.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Producers sending to one consumer thread through MessageQueue, against a
+// mutex and std::deque, which copies each message in and out.
+// Throughput is the time per message from the first send to the last one handled,
+// and latency the mean time from a message being sent to it being handled.
+
+#include "enum.hpp"
+#include "message_queue.hpp"
+
+#include "bench.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+constexpr int messages = 400000;
+
+struct Tick {
+    std::int64_t sent;
+    int value;
+};
+
+struct Order {
+    std::int64_t sent;
+    std::uint64_t id;
+    std::uint32_t price;
+    std::uint32_t quantity;
+};
+
+using Message = venum::EnumT<Tick, Order, std::string>;
+
+std::int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct LockFree {
+    template<typename T, typename... Args>
+    void send(Args&&... args) {
+        queue.emplace<T>(std::forward<Args>(args)...);
+    }
+
+    template<typename... Fs>
+    std::size_t receive(Fs&&... fs) {
+        return queue.drain(fs...);
+    }
+
+    venum::MessageQueue<Tick, Order, std::string> queue{ 1024 };
+};
+
+// The queue as it was, one message at a time under the lock
+struct Locked {
+    template<typename T, typename... Args>
+    void send(Args&&... args) {
+        Message message(venum::InPlace<T>(), std::forward<Args>(args)...);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(message);
+    }
+
+    template<typename... Fs>
+    std::size_t receive(Fs&&... fs) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if(queue.empty()) {
+            return 0;
+        }
+
+        Message message = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        message.match(fs...);
+        return 1;
+    }
+
+    std::mutex mutex;
+    std::deque<Message> queue;
+};
+
+template<typename Queue>
+void run(const std::string& name, int producers) {
+    int each = messages / producers;
+    double latency = 0;
+
+    double ns = bench::measure(static_cast<std::size_t>(each * producers), [&]() {
+        Queue queue;
+
+        std::vector<std::thread> threads;
+        for(int p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, each, p]() {
+                for(int i = 0; i < each; ++i) {
+                    if(i % 16 == 0) {
+                        queue.template send<std::string>("order cancelled");
+                    } else if(i % 2 == 0) {
+                        queue.template send<Order>(Order{ now(), static_cast<std::uint64_t>(i), 100, static_cast<std::uint32_t>(p) });
+                    } else {
+                        queue.template send<Tick>(Tick{ now(), i });
+                    }
+                }
+            });
+        }
+
+        std::int64_t waited = 0;
+        std::int64_t timed = 0;
+        std::size_t received = 0;
+
+        while(received < static_cast<std::size_t>(each * producers)) {
+            std::size_t handled = queue.receive(
+                [&](const Tick& t) { waited += now() - t.sent; ++timed; },
+                [&](const Order& o) { waited += now() - o.sent; ++timed; },
+                [&](const std::string& s) { bench::do_not_optimize(s.size()); }
+            );
+
+            if(handled == 0) {
+                std::this_thread::yield();
+            }
+
+            received += handled;
+        }
+
+        for(auto& thread : threads) {
+            thread.join();
+        }
+
+        double mean = static_cast<double>(waited) / static_cast<double>(timed);
+        latency = (latency == 0) ? mean : std::min(latency, mean);
+    }, 3);
+
+    std::string suffix = name + "/producers=" + std::to_string(producers);
+    bench::report("throughput/" + suffix, ns);
+    bench::report("latency/" + suffix, latency);
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    for(int producers : { 1, 2, 4, 8 }) {
+        run<LockFree>("lock-free", producers);
+        run<Locked>("mutex", producers);
+    }
+}
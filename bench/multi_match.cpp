@@ -0,0 +1,127 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/multi_match.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Compares venum::match over two and three enums, which goes through a single
+// flattened table, against the equivalent nested apply calls.
+
+#include "enum.hpp"
+
+#include "bench.hpp"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+template<std::size_t n>
+struct Alt {
+    int value;
+};
+
+template<typename>
+struct MakeEnum;
+
+template<std::size_t... ns>
+struct MakeEnum<std::index_sequence<ns...>> {
+    using type = venum::EnumT<Alt<ns>...>;
+
+    template<std::size_t n>
+    static type make(int value) {
+        return type::template construct<Alt<n>>(Alt<n>{value});
+    }
+
+    // Construct a random alternative
+    static type random(std::mt19937& rng) {
+        using Make = type (*)(int);
+        static constexpr Make makers[] = { &make<ns>... };
+
+        return makers[rng() % sizeof...(ns)](static_cast<int>(rng() % 100));
+    }
+};
+
+using Event = MakeEnum<std::make_index_sequence<8>>;
+using State = MakeEnum<std::make_index_sequence<8>>;
+
+constexpr std::size_t count = 1 << 16;
+constexpr std::size_t rounds = 32;
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    std::mt19937 rng(42);
+
+    std::vector<Event::type> events;
+    std::vector<State::type> states;
+    std::vector<State::type> extra;
+
+    for(std::size_t i = 0; i < count; ++i) {
+        events.push_back(Event::random(rng));
+        states.push_back(State::random(rng));
+        extra.push_back(State::random(rng));
+    }
+
+    double flat2 = bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            int sum = 0;
+            for(std::size_t i = 0; i < count; ++i) {
+                sum += venum::match([](auto& e, auto& s) { return e.value + s.value; }, events[i], states[i]);
+            }
+            bench::do_not_optimize(sum);
+        }
+    });
+
+    double nested2 = bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            int sum = 0;
+            for(std::size_t i = 0; i < count; ++i) {
+                sum += events[i].apply([&](auto& e) {
+                    return states[i].apply([&](auto& s) { return e.value + s.value; });
+                });
+            }
+            bench::do_not_optimize(sum);
+        }
+    });
+
+    double flat3 = bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            int sum = 0;
+            for(std::size_t i = 0; i < count; ++i) {
+                sum += venum::match([](auto& e, auto& s, auto& x) { return e.value + s.value + x.value; }, events[i], states[i], extra[i]);
+            }
+            bench::do_not_optimize(sum);
+        }
+    });
+
+    double nested3 = bench::measure(count * rounds, [&]() {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            int sum = 0;
+            for(std::size_t i = 0; i < count; ++i) {
+                sum += events[i].apply([&](auto& e) {
+                    return states[i].apply([&](auto& s) {
+                        return extra[i].apply([&](auto& x) { return e.value + s.value + x.value; });
+                    });
+                });
+            }
+            bench::do_not_optimize(sum);
+        }
+    });
+
+    bench::report("match 8x8/flattened table", flat2);
+    bench::report("match 8x8/nested apply", nested2);
+    bench::report("match 8x8x8/flattened table", flat3);
+    bench::report("match 8x8x8/nested apply", nested3);
+}
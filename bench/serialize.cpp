@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/serialize.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Encodes and decodes a stream of mixed messages, with and without a string
+// variant, and reads the trivially copyable stream in place with EnumView.
+// Results are per message, with throughput over the encoded bytes.
+
+#include "enum.hpp"
+#include "serialize.hpp"
+
+#include "bench.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Order {
+    std::uint64_t id;
+    std::uint32_t price;
+    std::uint32_t quantity;
+};
+
+struct Cancel {
+    std::uint64_t id;
+};
+
+using Flat = venum::EnumT<Order, Cancel, std::uint32_t>;
+using Mixed = venum::EnumT<Order, Cancel, std::string>;
+
+constexpr std::size_t messages = 1000000;
+
+template<typename E, typename Make>
+void run(const std::string& name, Make make) {
+    std::mt19937 random(9);
+    std::vector<E> values;
+    for(std::size_t i = 0; i < messages; ++i) {
+        values.push_back(make(random));
+    }
+
+    venum::Bytes bytes;
+    for(auto& value : values) {
+        venum::encode(value, bytes);
+    }
+
+    double per_message = double(bytes.size()) / messages;
+
+    // Into a buffer that's already big enough, as a sender reusing its buffer would
+    venum::Bytes out;
+    out.reserve(bytes.size());
+
+    bench::report("encode/" + name, bench::measure(messages, [&]() {
+        out.clear();
+
+        for(auto& value : values) {
+            venum::encode(value, out);
+        }
+
+        bench::do_not_optimize(out.data());
+    }), per_message);
+
+    bench::report("decode/" + name, bench::measure(messages, [&]() {
+        venum::ByteReader in(bytes);
+        std::size_t count = 0;
+
+        while(auto decoded = venum::decode<E>(in)) {
+            count += decoded->which();
+        }
+
+        bench::do_not_optimize(count);
+    }), per_message);
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    auto flat = [](std::mt19937& random) {
+        switch(random() % 3) {
+            case 0: return Flat(Order{ random(), static_cast<std::uint32_t>(random() % 1000), static_cast<std::uint32_t>(random() % 100) });
+            case 1: return Flat(Cancel{ random() });
+            default: return Flat(static_cast<std::uint32_t>(random()));
+        }
+    };
+
+    run<Flat>("flat", flat);
+
+    run<Mixed>("with strings", [](std::mt19937& random) {
+        switch(random() % 3) {
+            case 0: return Mixed(Order{ random(), static_cast<std::uint32_t>(random() % 1000), static_cast<std::uint32_t>(random() % 100) });
+            case 1: return Mixed(Cancel{ random() });
+            default: return Mixed(std::string(8 + random() % 24, 'x'));
+        }
+    });
+
+    // The flat stream again, read where it lies
+    std::mt19937 random(9);
+    venum::Bytes bytes;
+    for(std::size_t i = 0; i < messages; ++i) {
+        venum::encode(flat(random), bytes);
+    }
+
+    bench::report("view/flat", bench::measure(messages, [&]() {
+        venum::ByteReader in(bytes);
+        std::uint64_t sum = 0;
+
+        while(auto view = venum::EnumView<Flat>::read(in)) {
+            sum += view->match(
+                [](const Order& o) { return o.id; },
+                [](const Cancel& c) { return c.id; },
+                [](std::uint32_t i) { return std::uint64_t(i); }
+            );
+        }
+
+        bench::do_not_optimize(sum);
+    }), double(bytes.size()) / messages);
+}
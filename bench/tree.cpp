@@ -0,0 +1,235 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/tree.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Inserts and looks up sorted keys, the worst case for an unbalanced BST,
+// comparing the AVL tree against the unbalanced one and std::set.
+// The unbalanced tree is quadratic on this input, as each insert walks down every
+// key before it, so it only gets a small key count.
+// Also compares a range scan from lower_bound against filtering with apply,
+// and random lookups in a bulk-loaded tree against its frozen layout.
+// Then times the parallel passes from one thread up to one per core, and
+// publishing an updated copy of a tree by copying it or as a persistent version.
+
+#include "enum.hpp"
+#include "optional.hpp"
+#include "persistent_tree.hpp"
+#include "tree.hpp"
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int big = 1000000;
+constexpr int small = 10000;
+
+template<typename Set>
+void run(const std::string& name, int count, Set make) {
+    std::string suffix = "/" + name + "/n=" + std::to_string(count);
+
+    // Building and throwing away the whole tree, as for a batch
+    bench::report("sorted insert+teardown" + suffix, bench::measure(count, [&]() {
+        auto set = make();
+        for(int i = 0; i < count; ++i) {
+            set.insert(i);
+        }
+    }, 3));
+
+    auto set = make();
+    for(int i = 0; i < count; ++i) {
+        set.insert(i);
+    }
+
+    bench::report("lookup" + suffix, bench::measure(count, [&]() {
+        int found = 0;
+        for(int i = 0; i < count; ++i) {
+            found += set.count(i);
+        }
+        bench::do_not_optimize(found);
+    }, 3));
+}
+
+// Gives Tree the same interface as std::set for the above
+template<typename Balance, typename Storage = ArenaNodes>
+struct TreeSet : Tree<int, Balance, Storage> {
+    int count(int i) const {
+        return this->contains(i) ? 1 : 0;
+    }
+};
+
+// Sums the 100 keys from each of a spread of starting points, by walking
+// from lower_bound and by filtering the whole tree with apply
+void range_scan() {
+    constexpr int queries = 64;
+    constexpr int width = 100;
+
+    Tree<int> tree;
+    for(int i = 0; i < big; ++i) {
+        tree.insert(i);
+    }
+
+    bench::report("range scan lower_bound/n=" + std::to_string(big), bench::measure(queries, [&]() {
+        for(int q = 0; q < queries; ++q) {
+            int start = q * (big / queries);
+            long sum = 0;
+
+            for(auto it = tree.lower_bound(start); it != tree.end() && *it < start + width; ++it) {
+                sum += *it;
+            }
+
+            bench::do_not_optimize(sum);
+        }
+    }, 3));
+
+    bench::report("range scan apply/n=" + std::to_string(big), bench::measure(queries, [&]() {
+        for(int q = 0; q < queries; ++q) {
+            int start = q * (big / queries);
+            long sum = 0;
+
+            tree.apply([&](int i) {
+                if(i >= start && i < start + width) {
+                    sum += i;
+                }
+            });
+
+            bench::do_not_optimize(sum);
+        }
+    }, 3));
+}
+
+// Looks up random keys, half of them missing, so the lookups miss the cache
+template<typename Contains>
+void random_lookup(const std::string& name, const std::vector<int>& keys, Contains contains) {
+    bench::report("random lookup/" + name + "/n=" + std::to_string(big), bench::measure(keys.size(), [&]() {
+        int found = 0;
+        for(int k : keys) {
+            found += contains(k) ? 1 : 0;
+        }
+        bench::do_not_optimize(found);
+    }, 3));
+}
+
+void frozen_lookup() {
+    std::vector<int> sorted;
+    for(int i = 0; i < big; ++i) {
+        sorted.push_back(i * 2);
+    }
+
+    std::mt19937 random(42);
+    std::vector<int> keys(big);
+    std::generate(keys.begin(), keys.end(), [&]() { return static_cast<int>(random() % (2 * big)); });
+
+    auto tree = Tree<int>::build_from_sorted(sorted.begin(), sorted.end());
+    auto frozen = tree.freeze();
+    std::set<int> set(sorted.begin(), sorted.end());
+
+    bench::report("build_from_sorted/n=" + std::to_string(big), bench::measure(big, [&]() {
+        auto built = Tree<int>::build_from_sorted(sorted.begin(), sorted.end());
+        bench::do_not_optimize(built);
+    }, 3));
+
+    random_lookup("avl arena", keys, [&](int k) { return tree.contains(k); });
+    random_lookup("frozen", keys, [&](int k) { return frozen.contains(k); });
+    random_lookup("std::set", keys, [&](int k) { return set.count(k) != 0; });
+}
+
+// Each pass does some arithmetic per value, as a sum alone is limited by memory bandwidth
+void parallel_scaling() {
+    std::mt19937 random(7);
+    std::vector<int> values(big);
+    std::generate(values.begin(), values.end(), [&]() { return static_cast<int>(random()); });
+
+    auto tree = Tree<int>::build_from_unsorted(values.begin(), values.end(), 1);
+    auto work = [](int i) {
+        unsigned x = static_cast<unsigned>(i);
+        for(int r = 0; r < 16; ++r) {
+            x = x * 1664525u + 1013904223u;
+        }
+        return static_cast<long>(x >> 16);
+    };
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+    for(unsigned threads = 1; ; threads = std::min(threads * 2, cores)) {
+        std::string suffix = "/threads=" + std::to_string(threads) + "/n=" + std::to_string(big);
+
+        bench::report("parallel_reduce" + suffix, bench::measure(big, [&]() {
+            long sum = tree.parallel_reduce(0L, work, [](long a, long b) { return a + b; }, threads);
+            bench::do_not_optimize(sum);
+        }, 3));
+
+        bench::report("build_from_unsorted" + suffix, bench::measure(big, [&]() {
+            auto built = Tree<int>::build_from_unsorted(values.begin(), values.end(), threads);
+            bench::do_not_optimize(built);
+        }, 3));
+
+        if(threads == cores) {
+            break;
+        }
+    }
+}
+
+// Changes one key and hands out the new version, keeping the old one for its readers
+void publish() {
+    constexpr int updates = 16;
+
+    std::vector<int> sorted;
+    PersistentTree<int> persistent;
+    for(int i = 0; i < big; ++i) {
+        sorted.push_back(i);
+        persistent = persistent.insert(i);
+    }
+
+    auto tree = Tree<int>::build_from_sorted(sorted.begin(), sorted.end());
+
+    bench::report("publish copy/n=" + std::to_string(big), bench::measure(updates, [&]() {
+        for(int u = 0; u < updates; ++u) {
+            auto copy = Tree<int>::build_from_sorted(tree.begin(), tree.end());
+            copy.insert(big + u);
+            bench::do_not_optimize(copy);
+        }
+    }, 3));
+
+    bench::report("publish persistent/n=" + std::to_string(big), bench::measure(updates, [&]() {
+        for(int u = 0; u < updates; ++u) {
+            auto version = persistent.insert(big + u);
+            bench::do_not_optimize(version);
+        }
+    }, 3));
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    run("avl arena", big, []() { return TreeSet<AVL>(); });
+    run("avl shared_ptr", big, []() { return TreeSet<AVL, SharedNodes>(); });
+    run("std::set", big, []() { return std::set<int>(); });
+
+    run("avl arena", small, []() { return TreeSet<AVL>(); });
+    run("unbalanced arena", small, []() { return TreeSet<Unbalanced>(); });
+    run("std::set", small, []() { return std::set<int>(); });
+
+    range_scan();
+    frozen_lookup();
+    parallel_scaling();
+    publish();
+}
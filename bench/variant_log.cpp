@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/variant_log.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Writes a log of 10^6 events, then compares ways to replay it: decoding the
+// whole file into a std::vector of EnumT first, against visiting the mapped
+// log in order and visiting one variant through the tag index.
+// Opening is timed with the offset index and without it, when the records
+// have to be found by reading through the log.
+
+#include "enum.hpp"
+#include "serialize.hpp"
+#include "variant_log.hpp"
+
+#include "bench.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Trade {
+    std::uint64_t id;
+    std::uint32_t price;
+    std::uint32_t quantity;
+};
+
+struct Quote {
+    std::uint32_t bid;
+    std::uint32_t ask;
+};
+
+using Log = venum::VariantLog<Trade, Quote, std::uint32_t>;
+using Event = Log::Enum;
+
+constexpr std::size_t events = 1000000;
+const std::string path = "bench_variant_log.log";
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    std::mt19937 random(3);
+
+    bench::report("append", bench::measure(events, [&]() {
+        std::remove(path.c_str());
+        auto log = Log::open(path);
+
+        for(std::size_t i = 0; i < events; ++i) {
+            switch(random() % 10) {
+                case 0: log->append(Event(Trade{ i, static_cast<std::uint32_t>(random() % 1000), static_cast<std::uint32_t>(random() % 100) })); break;
+                case 1: log->append(Event(std::uint32_t(i))); break;
+                default: log->append(Event(Quote{ static_cast<std::uint32_t>(random() % 1000), static_cast<std::uint32_t>(random() % 1000) })); break;
+            }
+        }
+    }, 1));
+
+    venum::LogOptions indexed;
+    indexed.write = false;
+    indexed.tag_index = true;
+
+    venum::LogOptions unindexed = indexed;
+    unindexed.offset_index = false;
+
+    bench::report("open with index", bench::measure(1, [&]() {
+        auto log = Log::open(path, indexed);
+        bench::do_not_optimize(log->size());
+    }, 3));
+
+    bench::report("open by reading through", bench::measure(1, [&]() {
+        auto log = Log::open(path, unindexed);
+        bench::do_not_optimize(log->size());
+    }, 3));
+
+    // The old way: read the file, decode all of it, then visit
+    bench::report("replay decoded vector", bench::measure(events, [&]() {
+        std::ifstream file(path, std::ios::binary);
+        venum::Bytes bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        venum::ByteReader in(bytes.data() + 16, bytes.size() - 16);
+        std::vector<Event> decoded;
+        while(auto e = venum::decode<Event>(in)) {
+            decoded.push_back(*e);
+        }
+
+        std::uint64_t sum = 0;
+        for(auto& e : decoded) {
+            sum += e.match(
+                [](const Trade& t) { return std::uint64_t(t.price); },
+                [](const Quote& q) { return std::uint64_t(q.bid); },
+                [](std::uint32_t i) { return std::uint64_t(i); }
+            );
+        }
+
+        bench::do_not_optimize(sum);
+    }, 3));
+
+    auto log = Log::open(path, indexed);
+
+    bench::report("replay mapped in order", bench::measure(events, [&]() {
+        std::uint64_t sum = 0;
+        log->for_each(
+            [&](const Trade& t) { sum += t.price; },
+            [&](const Quote& q) { sum += q.bid; },
+            [&](std::uint32_t i) { sum += i; }
+        );
+
+        bench::do_not_optimize(sum);
+    }, 3));
+
+    bench::report("replay mapped trades only", bench::measure(events, [&]() {
+        std::uint64_t sum = 0;
+        log->for_each_of<Trade>([&](const Trade& t) { sum += t.price; });
+
+        bench::do_not_optimize(sum);
+    }, 3));
+
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+}
@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/variant_vector.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Sums a stream of events, two small kinds mixed at random with a large
+// one at 1 in 100, stored as a std::vector of EnumT and as a VariantVector,
+// visited with match, in order, and by type.
+
+#include "enum.hpp"
+#include "variant_vector.hpp"
+
+#include "bench.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct Tick {
+    std::uint32_t value;
+};
+
+struct Mark {
+    std::uint16_t value;
+};
+
+struct Snapshot {
+    std::uint32_t value;
+    unsigned char payload[252];
+};
+
+using Event = venum::EnumT<Tick, Mark, Snapshot>;
+
+constexpr std::size_t events = 1000000;
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    std::mt19937 random(5);
+    std::vector<Event> enums;
+    venum::VariantVector<Tick, Mark, Snapshot> vector;
+
+    for(std::size_t i = 0; i < events; ++i) {
+        std::uint32_t r = random() % 100;
+
+        if(r == 0) {
+            enums.push_back(Event(Snapshot{ r, {} }));
+        } else if(r % 2 == 0) {
+            enums.push_back(Event(Tick{ r }));
+        } else {
+            enums.push_back(Event(Mark{ static_cast<std::uint16_t>(r) }));
+        }
+
+        vector.push_back(enums.back());
+    }
+
+    bench::report("vector<EnumT> match", bench::measure(events, [&]() {
+        std::uint64_t sum = 0;
+        for(auto& e : enums) {
+            sum += e.match(
+                [](const Tick& t) { return t.value; },
+                [](const Mark& m) { return static_cast<std::uint32_t>(m.value); },
+                [](const Snapshot& s) { return s.value; }
+            );
+        }
+        bench::do_not_optimize(sum);
+    }));
+
+    bench::report("VariantVector for_each", bench::measure(events, [&]() {
+        std::uint64_t sum = 0;
+        vector.for_each(
+            [&](const Tick& t) { sum += t.value; },
+            [&](const Mark& m) { sum += m.value; },
+            [&](const Snapshot& s) { sum += s.value; }
+        );
+        bench::do_not_optimize(sum);
+    }));
+
+    bench::report("VariantVector for_each_by_type", bench::measure(events, [&]() {
+        std::uint64_t sum = 0;
+        vector.for_each_by_type(
+            [&](const Tick& t) { sum += t.value; },
+            [&](const Mark& m) { sum += m.value; },
+            [&](const Snapshot& s) { sum += s.value; }
+        );
+        bench::do_not_optimize(sum);
+    }));
+}
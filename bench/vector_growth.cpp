@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/vector_growth.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Compares growing a std::vector of an enum whose variants are all trivial
+// (and so is trivially copyable itself) against one with an equivalent
+// variant that has user-provided copy and move constructors.
+
+#include "enum.hpp"
+
+#include "bench.hpp"
+
+#include <vector>
+
+struct Thing {
+    int i;
+    char c;
+};
+
+struct UserThing {
+    int i;
+    char c;
+
+    UserThing(int i, char c) : i(i), c(c) {}
+    UserThing(const UserThing& other) : i(other.i), c(other.c) {}
+    UserThing(UserThing&& other) noexcept : i(other.i), c(other.c) {}
+    ~UserThing() {}
+};
+
+using Trivial = venum::EnumT<int, float, Thing>;
+using NonTrivial = venum::EnumT<int, float, UserThing>;
+
+constexpr std::size_t count = 1 << 20;
+
+template<typename E, typename T>
+double grow() {
+    return bench::measure(count, []() {
+        std::vector<E> values;
+
+        for(std::size_t i = 0; i < count; ++i) {
+            switch(i % 3) {
+                case 0: values.push_back(E(static_cast<int>(i))); break;
+                case 1: values.push_back(E(static_cast<float>(i))); break;
+                default: values.push_back(E(T{static_cast<int>(i), 'a'})); break;
+            }
+        }
+
+        bench::do_not_optimize(values.data());
+    });
+}
+
+template<typename E>
+double copy(const std::vector<E>& values) {
+    return bench::measure(values.size(), [&values]() {
+        std::vector<E> copied(values);
+        bench::do_not_optimize(copied.data());
+    });
+}
+
+int main(int argc, char* argv[]) {
+    bench::init(argc, argv);
+
+    static_assert(std::is_trivially_copyable<Trivial>::value, "Trivial should be trivially copyable");
+    static_assert(!std::is_trivially_copyable<NonTrivial>::value, "NonTrivial should not be trivially copyable");
+
+    bench::report("push_back growth/trivial", grow<Trivial, Thing>());
+    bench::report("push_back growth/non-trivial", grow<NonTrivial, UserThing>());
+
+    std::vector<Trivial> trivial(count, Trivial(Thing{1, 'a'}));
+    std::vector<NonTrivial> non_trivial(count, NonTrivial(UserThing{1, 'a'}));
+
+    bench::report("vector copy/trivial", copy(trivial));
+    bench::report("vector copy/non-trivial", copy(non_trivial));
+}
@@ -0,0 +1,164 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/atomic_enum.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_ATOMIC_ENUM_HPP
+#define ENUM_ATOMIC_ENUM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "enum.hpp"
+
+namespace venum {
+
+// Two words, for enums that don't fit in one
+// Atomics this size need libatomic with GCC, which uses cmpxchg16b on x86-64
+struct alignas(16) AtomicPair {
+    std::uint64_t words[2];
+};
+
+// An EnumT<Ts...> of trivially copyable variants that threads can read and write without a lock
+//
+// The object and its tag are packed into one 8 or 16 byte word, which is loaded, stored and
+// swapped as a whole, so a reader never sees the tag of one variant with the object of another.
+// Bytes past the end of the object are always zero, but padding inside an object is compared
+// too, so compare_exchange can fail for objects that differ only in their padding.
+// The failed compare_exchange updates expected to the word as it is, so a retry settles.
+template<typename... Ts>
+class AtomicEnum {
+public:
+    using Enum = EnumT<Ts...>;
+    using Tag = SmallestTag<sizeof...(Ts)>;
+
+    // The object goes first, then the tag, with no padding between
+    static constexpr std::size_t packed_size = Enum::storage_size + sizeof(Tag);
+
+    static_assert(And<std::is_trivially_copyable<Ts>...>::value, "AtomicEnum needs trivially copyable variants");
+    static_assert(packed_size <= 16, "AtomicEnum needs the variants and tag to fit in 16 bytes");
+
+    using Word = typename std::conditional<packed_size <= 8, std::uint64_t, AtomicPair>::type;
+
+    AtomicEnum(const Enum& e) noexcept : word(pack(e)) {}
+
+    AtomicEnum(const AtomicEnum&) = delete;
+    AtomicEnum& operator=(const AtomicEnum&) = delete;
+
+    Enum load(std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return unpack(word.load(order));
+    }
+
+    void store(const Enum& e, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        word.store(pack(e), order);
+    }
+
+    // Stores e, returning what it replaced
+    Enum exchange(const Enum& e, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return unpack(word.exchange(pack(e), order));
+    }
+
+    // Stores desired if the enum is still expected, otherwise sets expected to what it is
+    bool compare_exchange(Enum& expected, const Enum& desired,
+        std::memory_order order = std::memory_order_seq_cst) noexcept {
+
+        Word current = pack(expected);
+
+        if(word.compare_exchange_strong(current, pack(desired), order)) {
+            return true;
+        }
+
+        expected = unpack(current);
+        return false;
+    }
+
+    // As compare_exchange, but may fail even when the enum is expected, for use in a loop
+    bool compare_exchange_weak(Enum& expected, const Enum& desired,
+        std::memory_order order = std::memory_order_seq_cst) noexcept {
+
+        Word current = pack(expected);
+
+        if(word.compare_exchange_weak(current, pack(desired), order)) {
+            return true;
+        }
+
+        expected = unpack(current);
+        return false;
+    }
+
+    // False if the platform implements the word with a lock, which some do for 16 bytes
+    bool is_lock_free() const noexcept {
+        return word.is_lock_free();
+    }
+
+private:
+    using Bytes = unsigned char[sizeof(Word)];
+
+    static Word pack(const Enum& e) noexcept {
+        Bytes bytes = {};
+
+        // An empty object's byte is all padding, so it is left as zero
+        e.apply([&bytes](const auto& t) {
+            if(!std::is_empty<typename std::decay<decltype(t)>::type>::value) {
+                std::memcpy(bytes, &t, sizeof(t));
+            }
+        });
+
+        Tag tag = static_cast<Tag>(e.which());
+        std::memcpy(bytes + Enum::storage_size, &tag, sizeof(Tag));
+
+        Word result;
+        std::memcpy(&result, bytes, sizeof(Word));
+        return result;
+    }
+
+    static Enum unpack(const Word& w) noexcept {
+        return unpack(w, std::index_sequence_for<Ts...>());
+    }
+
+    template<std::size_t... ns>
+    static Enum unpack(const Word& w, std::index_sequence<ns...>) noexcept {
+        using Fn = Enum (*)(const unsigned char*);
+        static constexpr Fn table[] = { &unpack_nth<ns>... };
+
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&w);
+
+        Tag tag;
+        std::memcpy(&tag, bytes + Enum::storage_size, sizeof(Tag));
+
+        return table[tag](bytes);
+    }
+
+    template<std::size_t n>
+    static Enum unpack_nth(const unsigned char* bytes) noexcept {
+        using T = typename TypeList<Ts...>::template Nth<n>;
+
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type raw;
+        std::memcpy(&raw, bytes, sizeof(T));
+
+        return Enum(InPlaceIndex<n>(), *reinterpret_cast<const T*>(&raw));
+    }
+
+    std::atomic<Word> word;
+};
+
+}
+
+#endif
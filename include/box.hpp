@@ -0,0 +1,268 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/box.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_BOX_HPP
+#define ENUM_BOX_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "enum.hpp"
+
+namespace venum {
+
+// Memory for the objects of one boxed type
+//
+// Each thread allocates from and frees to its own list of free slots, so neither takes a lock.
+// New slots are carved from slabs, and slots freed on one thread can be allocated on another:
+// a thread holding more than two batches of free slots passes a batch to a shared list,
+// which a thread that runs out takes from before making a new slab, and a thread
+// that exits passes on everything it holds.
+// Slabs are never freed, as a slot may be in use anywhere, so the pool keeps
+// the most memory its type has needed at once.
+template<typename T>
+class BoxPool {
+public:
+    static constexpr std::size_t batch_size = 256;
+
+    static void* allocate() {
+        if(!free) {
+            refill();
+        }
+
+        Slot* slot = free;
+        free = slot->next;
+        --count;
+
+        return slot;
+    }
+
+    static void deallocate(void* p) noexcept {
+        if(!free) {
+            exit_hook();
+        }
+
+        Slot* slot = static_cast<Slot*>(p);
+        slot->next = free;
+        free = slot;
+
+        if(++count >= 2 * batch_size) {
+            give_back(batch_size);
+        }
+    }
+
+private:
+    union Slot {
+        Slot* next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    struct Batch {
+        Slot* first;
+        std::size_t count;
+    };
+
+    struct Shared {
+        std::mutex mutex;
+        std::vector<Batch> batches;
+        std::vector<std::unique_ptr<Slot[]>> slabs;
+    };
+
+    // Never destroyed, so boxes freed while the program exits still have somewhere to go
+    static Shared& shared() {
+        static Shared* shared = new Shared();
+        return *shared;
+    }
+
+    // Passes the thread's free slots on when it exits
+    struct ExitHook {
+        ~ExitHook() {
+            if(free) {
+                give_back(count);
+            }
+        }
+    };
+
+    static void exit_hook() {
+        static thread_local ExitHook hook;
+        (void)hook;
+    }
+
+    static void refill() {
+        exit_hook();
+
+        Shared& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        if(!s.batches.empty()) {
+            free = s.batches.back().first;
+            count = s.batches.back().count;
+            s.batches.pop_back();
+            return;
+        }
+
+        s.slabs.emplace_back(new Slot[batch_size]);
+        Slot* slab = s.slabs.back().get();
+
+        for(std::size_t i = 0; i + 1 < batch_size; ++i) {
+            slab[i].next = &slab[i + 1];
+        }
+
+        slab[batch_size - 1].next = nullptr;
+        free = slab;
+        count = batch_size;
+    }
+
+    // Moves the first n free slots to the shared list
+    static void give_back(std::size_t n) noexcept {
+        Slot* first = free;
+        Slot* last = free;
+
+        for(std::size_t i = 1; i < n; ++i) {
+            last = last->next;
+        }
+
+        free = last->next;
+        count -= n;
+        last->next = nullptr;
+
+        Shared& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.batches.push_back(Batch{ first, n });
+    }
+
+    static thread_local Slot* free;
+    static thread_local std::size_t count;
+};
+
+template<typename T>
+thread_local typename BoxPool<T>::Slot* BoxPool<T>::free = nullptr;
+
+template<typename T>
+thread_local std::size_t BoxPool<T>::count = 0;
+
+// A T stored out of line, for a variant that is rarely used and much larger than the others,
+// or one that contains the enum itself:
+//
+//   struct Add;
+//   using Expr = EnumT<double, Box<Add>>;
+//   struct Add { Expr lhs, rhs; };
+//
+// The enum only holds a pointer, so its storage is sized by the other variants,
+// and apply and match hand the handler the T itself. Copies are deep.
+// A moved from box is empty, as a moved from std::unique_ptr is: copying it gives another
+// empty box, and until it is assigned to, match passes it to a trailing error handler
+// as MovedFrom, or without one (and in apply) the policy's invalid is called.
+// The enum's valid() only looks at its tag, so it is still true.
+template<typename T>
+class Box {
+public:
+    template<typename... Args,
+        typename = typename std::enable_if<!IsCopyOf<Box, Args...>::value>::type,
+        typename = typename std::enable_if<std::is_constructible<T, Args...>::value>::type>
+    Box(Args&&... args) : object(make(std::forward<Args>(args)...)) {}
+
+    Box(const Box& other) : object(other.object ? make(*other) : nullptr) {}
+
+    Box(Box&& other) noexcept : object(other.object) {
+        other.object = nullptr;
+    }
+
+    Box& operator=(const Box& other) {
+        if(!other.object) {
+            release();
+        } else if(object) {
+            *object = *other;
+        } else {
+            object = make(*other);
+        }
+
+        return *this;
+    }
+
+    Box& operator=(Box&& other) noexcept {
+        if(this != &other) {
+            release();
+            object = other.object;
+            other.object = nullptr;
+        }
+
+        return *this;
+    }
+
+    ~Box() {
+        release();
+    }
+
+    T& operator*() noexcept {
+        return *object;
+    }
+
+    const T& operator*() const noexcept {
+        return *object;
+    }
+
+    T* operator->() noexcept {
+        return object;
+    }
+
+    const T* operator->() const noexcept {
+        return object;
+    }
+
+    // False once moved from
+    explicit operator bool() const noexcept {
+        return object != nullptr;
+    }
+
+private:
+    template<typename... Args>
+    static T* make(Args&&... args) {
+        void* p = BoxPool<T>::allocate();
+
+    #if VENUM_EXCEPTIONS
+        try {
+            return ::new (p) T(std::forward<Args>(args)...);
+        } catch(...) {
+            BoxPool<T>::deallocate(p);
+            throw;
+        }
+    #else
+        return ::new (p) T(std::forward<Args>(args)...);
+    #endif
+    }
+
+    void release() noexcept {
+        if(object) {
+            object->~T();
+            BoxPool<T>::deallocate(object);
+            object = nullptr;
+        }
+    }
+
+    T* object;
+};
+
+}
+
+#endif
@@ -0,0 +1,308 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/concurrent_tree.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_CONCURRENT_TREE_HPP
+#define ENUM_CONCURRENT_TREE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "optional.hpp"
+#include "persistent_tree.hpp"
+#include "tree.hpp"
+
+// An AVL tree that any number of threads can read while others write
+//
+// Nodes are never changed once the root can reach them. A write copies the path
+// from the root to the nodes it changes (see PersistentNode), then swaps in the new root, so a reader
+// sees the whole tree before the write or the whole tree after it, and never waits.
+// Writers take turns through a mutex.
+//
+// The nodes a write replaces are freed once no reader can still be looking at them,
+// tracked with epochs: a reader counts itself in under the current epoch, and the
+// writers only move to the next epoch, freeing what was replaced two epochs ago,
+// once every reader from the previous one has left.
+template<typename T>
+class ConcurrentTree {
+    using Node = PersistentNode<T, ArenaNodes>;
+
+    // Links are Optionals of node pointers, which are just a pointer with null as None,
+    // so the root can be swapped atomically
+    using Link = typename Node::Link;
+
+public:
+    class Snapshot;
+
+    using iterator = typename Node::Iterator;
+    using const_iterator = iterator;
+
+    ConcurrentTree() : root(Link::None()) {}
+
+    ConcurrentTree(const ConcurrentTree&) = delete;
+    ConcurrentTree& operator=(const ConcurrentTree&) = delete;
+
+    // No reader or writer may still be using the tree
+    ~ConcurrentTree() {
+        destroy_all(root.load());
+
+        for(auto& limbo : retired) {
+            for(Node* node : limbo) {
+                alloc.destroy(node);
+            }
+        }
+    }
+
+    void insert(T data) {
+        std::lock_guard<std::mutex> lock(writer);
+
+        Link old = root.load();
+        publish(Link::Some(Node::insert(*this, old, std::move(data))));
+    }
+
+    // Returns false if t was not in the tree
+    bool erase(const T& t) {
+        std::lock_guard<std::mutex> lock(writer);
+
+        bool erased = false;
+        Link updated = Node::erase(*this, root.load(), t, erased);
+
+        if(erased) {
+            publish(updated);
+        }
+
+        return erased;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(writer);
+
+        Link old = root.load();
+        retire_all(old);
+        publish(Link::None());
+    }
+
+    // A consistent view of the tree, which later writes don't change
+    // Nodes can't be freed while any snapshot is alive, so don't hold one for long
+    Snapshot snapshot() const {
+        return Snapshot(*this);
+    }
+
+    bool contains(const T& t) const {
+        return snapshot().contains(t);
+    }
+
+    // Calls f on each value in order, as of one moment
+    template<typename F>
+    void apply(F f) const {
+        snapshot().apply(f);
+    }
+
+    // Number of levels, 0 when empty
+    int height() const {
+        return snapshot().height();
+    }
+
+private:
+    // Readers count themselves in on one of a few stripes, picked per thread,
+    // so they don't all write to one cache line
+    static constexpr std::size_t stripe_count = 16;
+
+    struct Stripe {
+        std::atomic<std::size_t> readers[2] = {};
+        char padding[64 - 2 * sizeof(std::atomic<std::size_t>)];
+    };
+
+    static std::size_t stripe() {
+        static std::atomic<std::size_t> threads(0);
+        static thread_local std::size_t mine = threads++ % stripe_count;
+        return mine;
+    }
+
+    // Counts a reader in under the current epoch on a stripe, returning the epoch to leave with
+    // If the epoch moves on in between, the writer may have already checked
+    // this epoch's count, so try again under the new one
+    std::size_t enter(std::size_t s) const {
+        auto& counts = stripes[s].readers;
+
+        for(;;) {
+            std::size_t e = epoch.load();
+            counts[e & 1].fetch_add(1);
+
+            if(epoch.load() == e) {
+                return e;
+            }
+
+            counts[e & 1].fetch_sub(1);
+        }
+    }
+
+    void leave(std::size_t s, std::size_t e) const {
+        stripes[s].readers[e & 1].fetch_sub(1, std::memory_order_release);
+    }
+
+    // Swaps in a new root, then frees what older writes replaced if it can
+    // The nodes this write replaced were already retired under the current epoch
+    void publish(Link updated) {
+        root.store(updated);
+
+        // Readers from the previous epoch may still hold nodes retired in it,
+        // so the epoch can only advance once they have all left
+        std::size_t e = epoch.load();
+        std::size_t previous = (e + 1) & 1;
+
+        for(auto& s : stripes) {
+            if(s.readers[previous].load() != 0) {
+                return;
+            }
+        }
+
+        for(Node* node : retired[previous]) {
+            alloc.destroy(node);
+        }
+
+        retired[previous].clear();
+        epoch.store(e + 1);
+    }
+
+    // Writing, for PersistentNode
+    friend Node;
+
+    Node* make(T data, Link lhs, Link rhs) {
+        return alloc.make(std::move(data), lhs, rhs);
+    }
+
+    // The node will be freed once no reader can reach it
+    void retire(Node* node) {
+        retired[epoch.load() & 1].push_back(node);
+    }
+
+    void retire_all(Link link) {
+        std::vector<Node*> stack;
+
+        if(link.has_value()) {
+            stack.push_back(*link);
+        }
+
+        while(!stack.empty()) {
+            Node* next = stack.back();
+            stack.pop_back();
+
+            if(next->lhs.has_value()) {
+                stack.push_back(*next->lhs);
+            }
+
+            if(next->rhs.has_value()) {
+                stack.push_back(*next->rhs);
+            }
+
+            retire(next);
+        }
+    }
+
+    void destroy_all(Link link) {
+        std::vector<Node*> stack;
+
+        if(link.has_value()) {
+            stack.push_back(*link);
+        }
+
+        while(!stack.empty()) {
+            Node* node = stack.back();
+            stack.pop_back();
+
+            if(node->lhs.has_value()) {
+                stack.push_back(*node->lhs);
+            }
+
+            if(node->rhs.has_value()) {
+                stack.push_back(*node->rhs);
+            }
+
+            alloc.destroy(node);
+        }
+    }
+
+    std::atomic<Link> root;
+
+    mutable Stripe stripes[stripe_count];
+    std::atomic<std::size_t> epoch{ 0 };
+
+    // Only touched by the writer holding the mutex
+    std::mutex writer;
+    std::vector<Node*> retired[2];
+    ArenaNodes::Allocator<Node> alloc;
+};
+
+// Keeps the nodes of the tree as it was when taken alive, and reads from them
+template<typename T>
+class ConcurrentTree<T>::Snapshot {
+public:
+    // Remembers the stripe it counted in on, in case it is moved to another thread
+    explicit Snapshot(const ConcurrentTree& tree)
+        : tree(&tree), stripe(ConcurrentTree::stripe()), epoch(tree.enter(stripe)), root(tree.root.load()) {}
+
+    Snapshot(Snapshot&& other) noexcept : tree(other.tree), stripe(other.stripe), epoch(other.epoch), root(other.root) {
+        other.tree = nullptr;
+    }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+    Snapshot& operator=(Snapshot&&) = delete;
+
+    ~Snapshot() {
+        if(tree) {
+            tree->leave(stripe, epoch);
+        }
+    }
+
+    bool contains(const T& t) const {
+        return Node::contains(root, t);
+    }
+
+    template<typename F>
+    void apply(F f) const {
+        for(const T& t : *this) {
+            f(t);
+        }
+    }
+
+    iterator begin() const {
+        return iterator(root);
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    int height() const {
+        return Node::height(root);
+    }
+
+private:
+    const ConcurrentTree* tree;
+    std::size_t stripe;
+    std::size_t epoch;
+    Link root;
+};
+
+#endif
@@ -20,10 +20,23 @@
 #define ENUM_ENUM_HPP
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
 #include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
+// Exception support
+// Detects whether exceptions are enabled (e.g. not building with -fno-exceptions)
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define VENUM_EXCEPTIONS 1
+#else
+#define VENUM_EXCEPTIONS 0
+#endif
+
 namespace venum {
 
 // Index of T in Ts
@@ -65,6 +78,20 @@ struct Or<T> {
     static constexpr bool value = T::value;
 };
 
+// Variadic And
+template<typename... Args>
+struct And;
+
+template<typename T, typename... Args>
+struct And<T, Args...> {
+    static constexpr bool value = T::value && And<Args...>::value;
+};
+
+template<typename T>
+struct And<T> {
+    static constexpr bool value = T::value;
+};
+
 // TypeList 
 template<typename T, std::size_t n>
 struct NthImpl : public NthImpl<typename T::Tail, n - 1> {};
@@ -92,7 +119,8 @@ struct TypeList<H, Ts...> {
 VARIANT_ERROR_X(CopyThrew, VariantCopyThrew, "Variant invalidated after copy constructor throw") \
 VARIANT_ERROR_X(MoveThrew, VariantMoveThrew, "Variant invalidated after move constructor throw") \
 VARIANT_ERROR_X(MovedFrom, VariandMovedFrom, "Variant invalidated after being moved from") \
-VARIANT_ERROR_X(Unknown, UnknownVariantError, "Variant invalidated after copy constructor throw")
+VARIANT_ERROR_X(Unknown, UnknownVariantError, "Variant invalidated for an unknown reason") \
+VARIANT_ERROR_X(EmplaceThrew, VariantEmplaceThrew, "Variant invalidated after emplace constructor throw")
 
 // Error state enum
 #define VARIANT_ERROR_X(name, error, msg) name,
@@ -101,6 +129,17 @@ enum InvalidReason {
 };
 #undef VARIANT_ERROR_X
 
+// Number of error states
+#define VARIANT_ERROR_X(name, error, msg) + 1
+constexpr std::size_t invalid_states = 0 VARIANT_ERROR_EXPAND;
+#undef VARIANT_ERROR_X
+
+// Reason for an offset into the error states, with Unknown for anything past them
+// New reasons go at the end, so the values of the existing ones don't change
+constexpr InvalidReason invalid_reason(std::size_t n) {
+    return n < invalid_states ? static_cast<InvalidReason>(n) : InvalidReason::Unknown;
+}
+
 // Base exception class
 struct InvalidVariantError : public std::exception {
     InvalidVariantError() : std::exception() {}
@@ -126,20 +165,286 @@ struct error : public InvalidVariantError { \
 VARIANT_ERROR_EXPAND
 #undef VARIANT_ERROR_X
 
+// In place construction tags
+// Select the variant to construct by type or by index
+template<typename T>
+struct InPlace {};
+
+template<std::size_t n>
+struct InPlaceIndex {};
+
+// Boxed variants, see box.hpp
+// The enum stores the Box, and hands the object it points to to apply and match
+// A moved from box is empty: match passes a trailing error handler MovedFrom for it,
+// and otherwise reaching it calls the policy's invalid with MovedFrom
+template<typename T>
+class Box;
+
+template<typename T>
+struct Unbox {
+    using type = T;
+
+    static bool empty(const T&) noexcept {
+        return false;
+    }
+
+    template<typename Policy>
+    static T& get(T& t) {
+        return t;
+    }
+
+    template<typename Policy>
+    static const T& get(const T& t) {
+        return t;
+    }
+};
+
+template<typename T>
+struct Unbox<Box<T>> {
+    using type = T;
+
+    static bool empty(const Box<T>& box) noexcept {
+        return !box;
+    }
+
+    template<typename Policy>
+    static T& get(Box<T>& box) {
+        if(!box) {
+            Policy::invalid(InvalidReason::MovedFrom);
+        }
+
+        return *box;
+    }
+
+    template<typename Policy>
+    static const T& get(const Box<T>& box) {
+        if(!box) {
+            Policy::invalid(InvalidReason::MovedFrom);
+        }
+
+        return *box;
+    }
+};
+
+// True for a single argument of type E (or derived from it), to leave that to the copy/move constructors
+template<typename E, typename... Args>
+struct IsCopyOf : public std::false_type {};
+
+template<typename E, typename Arg>
+struct IsCopyOf<E, Arg> : public std::is_base_of<E, typename std::decay<Arg>::type> {};
+
+// Policy
+// Compile time configuration for an enum, derive from this to override parts of it
+struct DefaultPolicy {
+    // Type of the tag, or void for the smallest unsigned type that fits
+    using Tag = void;
+
+    // Whether a throwing copy/move is caught, invalidating the variant
+    // Without this no try/catch is generated, and a throwing copy/move terminates
+    static constexpr bool exceptions = VENUM_EXCEPTIONS;
+
+    // Called when an invalid variant is accessed without an error handler
+    [[noreturn]] static void invalid(InvalidReason reason) {
+    #if VENUM_EXCEPTIONS
+        #define VARIANT_ERROR_X(name, error, msg) case InvalidReason::name: throw error();
+
+        switch(reason) {
+            VARIANT_ERROR_EXPAND
+
+            default:
+                throw UnknownVariantError();
+        }
+
+        #undef VARIANT_ERROR_X
+    #else
+        std::abort();
+    #endif
+    }
+
+    // Called when get<T> is used with the wrong type
+    [[noreturn]] static void bad_access() {
+    #if VENUM_EXCEPTIONS
+        throw std::runtime_error("Attempted get<T> on incorrect type");
+    #else
+        std::abort();
+    #endif
+    }
+};
+
+// Policy that never throws, and aborts on an invalid access
+struct NoExceptionsPolicy : public DefaultPolicy {
+    static constexpr bool exceptions = false;
+
+    [[noreturn]] static void invalid(InvalidReason reason) {
+        std::abort();
+    }
+
+    [[noreturn]] static void bad_access() {
+        std::abort();
+    }
+};
+
+// Smallest unsigned type that can represent the given number of states
+template<std::size_t states>
+using SmallestTag = typename std::conditional<(states - 1 <= std::numeric_limits<std::uint8_t>::max()), std::uint8_t,
+    typename std::conditional<(states - 1 <= std::numeric_limits<std::uint16_t>::max()), std::uint16_t,
+        typename std::conditional<(states - 1 <= std::numeric_limits<std::uint32_t>::max()), std::uint32_t,
+            std::uint64_t
+        >::type
+    >::type
+>::type;
+
+// Tag type for a policy
+template<typename Tag, std::size_t states>
+struct TagFor {
+    static_assert(std::is_unsigned<Tag>::value, "Enum tag type must be an unsigned integer");
+    static_assert(states - 1 <= std::numeric_limits<Tag>::max(), "Enum tag type is too small for the number of variants");
+
+    using type = Tag;
+};
+
+template<std::size_t states>
+struct TagFor<void, states> {
+    using type = SmallestTag<states>;
+};
+
+// Storage layout
+// The tag either goes before or after the object, whichever leaves less padding
+template<typename Tag, std::size_t size, std::size_t align, bool tag_first>
+struct EnumLayout;
+
+// The tag starts out past every state, so there is nothing to destroy if a constructor throws
+template<typename Tag, std::size_t size, std::size_t align>
+struct EnumLayout<Tag, size, align, true> {
+    Tag tag = std::numeric_limits<Tag>::max();
+    alignas(align) unsigned char storage[size];
+};
+
+template<typename Tag, std::size_t size, std::size_t align>
+struct EnumLayout<Tag, size, align, false> {
+    alignas(align) unsigned char storage[size];
+    Tag tag = std::numeric_limits<Tag>::max();
+};
+
+template<typename Tag, std::size_t size, std::size_t align>
+using PackedEnumLayout = EnumLayout<Tag, size, align, 
+    sizeof(EnumLayout<Tag, size, align, true>) <= sizeof(EnumLayout<Tag, size, align, false>)>;
+
+// Properties of the variants that decide how the enum's special members behave
+template<typename... Ts>
+struct VariantTraits {
+    static constexpr bool trivially_destructible = And<std::is_trivially_destructible<Ts>...>::value;
+    static constexpr bool trivially_copyable = And<std::is_trivially_copyable<Ts>...>::value;
+
+    // If no variant can throw while moving, the enum never needs to be invalidated:
+    // moves leave the moved-from object in place, and anything else that may throw 
+    // does so before the old object is replaced
+    static constexpr bool never_empty = And<std::is_nothrow_move_constructible<Ts>...>::value;
+
+    // Otherwise, a throw is caught and invalidates the enum instead
+    static constexpr bool nothrow_copy = !never_empty || And<std::is_nothrow_copy_constructible<Ts>...>::value;
+    static constexpr bool nothrow_copy_assign = !never_empty 
+        || And<std::is_nothrow_copy_constructible<Ts>..., std::is_nothrow_copy_assignable<Ts>...>::value;
+    static constexpr bool nothrow_move_assign = !never_empty || And<std::is_nothrow_move_assignable<Ts>...>::value;
+};
+
+// Special members
+// These are left defaulted when every variant is trivial, so that the enum is too,
+// otherwise they defer to the implementations in Ops
+template<typename Ops, typename Layout, typename Traits, bool trivial = Traits::trivially_copyable>
+struct EnumCopyBase : public Layout {};
+
+template<typename Ops, typename Layout, typename Traits>
+struct EnumCopyBase<Ops, Layout, Traits, false> : public Layout {
+    EnumCopyBase() = default;
+
+    EnumCopyBase(const EnumCopyBase& other) noexcept(Traits::nothrow_copy) {
+        Ops::copy_construct(other, this);
+    }
+
+    EnumCopyBase(EnumCopyBase&& other) noexcept {
+        Ops::move_construct(std::move(other), this);
+    }
+
+    EnumCopyBase& operator=(const EnumCopyBase& other) noexcept(Traits::nothrow_copy_assign) {
+        Ops::copy_assign(other, this);
+        return *this;
+    }
+
+    EnumCopyBase& operator=(EnumCopyBase&& other) noexcept(Traits::nothrow_move_assign) {
+        Ops::move_assign(std::move(other), this);
+        return *this;
+    }
+};
+
+// This goes above the copy base, so it is not destroyed if a copy throws
+template<typename Ops, typename Base, typename Traits, bool trivial = Traits::trivially_destructible>
+struct EnumDestructorBase : public Base {};
+
+template<typename Ops, typename Base, typename Traits>
+struct EnumDestructorBase<Ops, Base, Traits, false> : public Base {
+    EnumDestructorBase() = default;
+    EnumDestructorBase(const EnumDestructorBase&) = default;
+    EnumDestructorBase(EnumDestructorBase&&) = default;
+    EnumDestructorBase& operator=(const EnumDestructorBase&) = default;
+    EnumDestructorBase& operator=(EnumDestructorBase&&) = default;
+
+    ~EnumDestructorBase() {
+        Ops::destroy(this);
+    }
+};
+
+template<typename Ops, typename Layout, typename Traits>
+using EnumBase = EnumDestructorBase<Ops, EnumCopyBase<Ops, Layout, Traits>, Traits>;
+
+// Multiple dispatch, see below
+template<typename F, typename... Es>
+struct MultiMatchT;
+
 // Enum implementation
-template<typename VariantT, typename... Variants>
-class EnumT {
+template<typename PolicyT, typename VariantT, typename... Variants>
+class BasicEnumT : private EnumBase<
+    BasicEnumT<PolicyT, VariantT, Variants...>,
+    PackedEnumLayout<
+        typename TagFor<typename PolicyT::Tag, sizeof...(Variants) + 1 + invalid_states>::type,
+        const_max(sizeof(VariantT), sizeof(Variants)...),
+        const_max(alignof(VariantT), alignof(Variants)...)>,
+    VariantTraits<VariantT, Variants...>> {
 public:
     static constexpr std::size_t storage_size = const_max(sizeof(VariantT), sizeof(Variants)...);
     static constexpr std::size_t storage_align = const_max(alignof(VariantT), alignof(Variants)...);
 
     static constexpr std::size_t variants = sizeof...(Variants) + 1;
 
+    // True if the enum can never be invalid, see VariantTraits
+    static constexpr bool never_empty = VariantTraits<VariantT, Variants...>::never_empty;
+
+    // Number of states the tag can be in when the enum is used
+    static constexpr std::size_t states = never_empty ? variants : variants + invalid_states;
+
+    using Policy = PolicyT;
+    using TagT = typename TagFor<typename Policy::Tag, variants + invalid_states>::type;
+
+    static_assert(VENUM_EXCEPTIONS || !Policy::exceptions, "Enum policy requires exceptions, which are disabled");
+
 private:
-    using Self = EnumT<VariantT, Variants...>;
+    using Self = BasicEnumT<Policy, VariantT, Variants...>;
     using VariantList = TypeList<VariantT, Variants...>;
 
-    using StorageT = typename std::aligned_storage<storage_size, storage_align>::type;
+    using Layout = PackedEnumLayout<TagT, storage_size, storage_align>;
+    using Layout::tag;
+    using Layout::storage;
+
+    template<typename, typename, typename, bool>
+    friend struct EnumDestructorBase;
+
+    template<typename, typename, typename, bool>
+    friend struct EnumCopyBase;
+
+    using NeverEmpty = std::integral_constant<bool, never_empty>;
+
+    template<typename, typename...>
+    friend struct MultiMatchT;
 
     // Implementation detail
     struct impl {
@@ -172,50 +477,101 @@ private:
             static constexpr bool value = std::is_same<typename std::decay<T>::type, typename std::decay<U>::type>::value && std::is_constructible<T, U>::value;
         };
 
-        // Helper
-        template<std::size_t n, std::size_t m, template<typename, std::size_t> typename F, typename... Args>
-        struct HelperT {
-            static auto call(const std::size_t& tag, Args... args) {
-                using T = typename Self::VariantList::template Nth<n>;
-
-                if(tag == n) {
+        // Dispatch
+        // Builds a table of function pointers indexed by tag, so every variant
+        // (and every invalid state) costs a single indirect call to reach
+        template<template<typename, std::size_t> typename F, std::size_t size, typename... Args>
+        struct DispatchT {
+            using Result = decltype(F<typename Self::VariantList::template Nth<0>, 0>::call(std::declval<Args>()...));
+            using Fn = Result (*)(const std::size_t&, Args...);
+
+            template<std::size_t n, bool valid = (n < Self::variants)>
+            struct Entry {
+                static Result call(const std::size_t& tag, Args... args) {
+                    using T = typename Self::VariantList::template Nth<n>;
                     return F<T, n>::call(std::forward<Args>(args)...);
-                } else {
-                    return HelperT<n + 1, m, F, Args...>::call(tag, std::forward<Args>(args)...);
                 }
-            }
-        };
+            };
 
-        template<std::size_t n, template<typename, std::size_t> typename F, typename... Args>
-        struct HelperT<n, n, F, Args...> {
-            static auto call(const std::size_t& tag, Args... args) {
-                using T = typename Self::VariantList::template Nth<n>;
-
-                if(tag == n) {
-                    return F<T, n>::call(std::forward<Args>(args)...);
-                } else {
-                    return F<T, n>::invalid(tag, std::forward<Args>(args)...);
+            template<std::size_t n>
+            struct Entry<n, false> {
+                static Result call(const std::size_t& tag, Args... args) {
+                    using T = typename Self::VariantList::template Nth<Self::variants - 1>;
+                    return F<T, Self::variants - 1>::invalid(tag, std::forward<Args>(args)...);
                 }
+            };
+
+            template<std::size_t... ns>
+            static Result call(const std::size_t& tag, std::index_sequence<ns...>, Args... args) {
+                static constexpr Fn table[] = { &Entry<ns>::call... };
+
+                // Only invalid tags can be out of range
+                return table[size == Self::variants ? tag : std::min(tag, size - 1)](tag, std::forward<Args>(args)...);
+            }
+
+            static Result call(const std::size_t& tag, Args... args) {
+                return call(tag, std::make_index_sequence<size>(), std::forward<Args>(args)...);
             }
         };
 
+        // Dispatch over every state the tag can be in when the enum is used,
+        // which leaves out the invalid states for a never empty enum
         template<template<typename, std::size_t> typename F, typename... Args>
-        using Helper = HelperT<0, Self::variants - 1, F, Args...>;
+        using Helper = DispatchT<F, Self::states, Args...>;
+
+        // Runs f, running on_throw instead if it throws
+        // If the policy disables exceptions this is just a call to f
+        template<typename F, typename G>
+        static void guard(F f, G on_throw, std::true_type) {
+        #if VENUM_EXCEPTIONS
+            try {
+                f();
+            } catch(std::exception&) {
+                on_throw();
+            }
+        #else
+            f();
+        #endif
+        }
+
+        template<typename F, typename G>
+        static void guard(F f, G on_throw, std::false_type) {
+            f();
+        }
+
+        template<typename F, typename G>
+        static void guard(F f, G on_throw) {
+            guard(f, on_throw, std::integral_constant<bool, Policy::exceptions>());
+        }
+
+        // Reason for an invalid tag
+        static InvalidReason reason(const std::size_t& tag) {
+            return invalid_reason(tag - variants);
+        }
 
         // Copy Constructor
         template<typename T, std::size_t n>
         struct CopyConstructorT {
-            static void call(const Self& from, Self* to) {
+            static void call(const Layout& from, Layout* to) {
+                copy(from, to, NeverEmpty());
+            }
+
+            // A throw propagates before the tag is set
+            static void copy(const Layout& from, Layout* to, std::true_type) {
+                ::new (&(to->storage)) T(*reinterpret_cast<const T*>(&(from.storage)));
                 to->tag = n;
+            }
 
-                try {
-                    ::new (&(to->storage)) T(*reinterpret_cast<T*>(&(from.storage)));
-                } catch(std::exception&) {
-                    to->tag = to->variants + InvalidReason::CopyThrew;
-                }
+            static void copy(const Layout& from, Layout* to, std::false_type) {
+                to->tag = n;
+
+                guard(
+                    [&]() { ::new (&(to->storage)) T(*reinterpret_cast<const T*>(&(from.storage))); },
+                    [&]() { to->tag = variants + InvalidReason::CopyThrew; }
+                );
             }
 
-            static void invalid(const std::size_t& tag, const Self& from, Self* to) {
+            static void invalid(const std::size_t& tag, const Layout& from, Layout* to) {
                 to->tag = from.tag;
             }
         };
@@ -223,140 +579,265 @@ private:
         // Move Constructor
         template<typename T, std::size_t n>
         struct MoveConstructorT {
-            static void call(Self&& from, Self* to) {
+            static void call(Layout&& from, Layout* to) {
+                move(std::move(from), to, NeverEmpty());
+            }
+
+            // The source keeps its moved-from object
+            static void move(Layout&& from, Layout* to, std::true_type) {
+                ::new (&(to->storage)) T(std::move(*reinterpret_cast<T*>(&(from.storage))));
                 to->tag = n;
-                from.tag = from.variants + InvalidReason::MovedFrom;
+            }
 
-                try {
-                    ::new (&(to->storage)) T(std::move(*reinterpret_cast<T*>(&(from.storage))));
-                } catch(std::exception&) {
-                    to->tag = to->variants + InvalidReason::MoveThrew;
-                }
+            static void move(Layout&& from, Layout* to, std::false_type) {
+                to->tag = n;
+                from.tag = variants + InvalidReason::MovedFrom;
+
+                guard(
+                    [&]() { ::new (&(to->storage)) T(std::move(*reinterpret_cast<T*>(&(from.storage)))); },
+                    [&]() { to->tag = variants + InvalidReason::MoveThrew; }
+                );
+
+                reinterpret_cast<T*>(&(from.storage))->~T();
             }
 
-            static void invalid(const std::size_t& tag, Self&& from, Self* to) {
+            static void invalid(const std::size_t& tag, Layout&& from, Layout* to) {
                 to->tag = from.tag;
-                from.tag = from.variants + InvalidReason::MovedFrom;
+                from.tag = variants + InvalidReason::MovedFrom;
             }
         };
 
         // Destructor
         template<typename T, std::size_t n>
         struct DestructorT {
-            static void call(Self* e) {
+            static void call(Layout* e) {
                 reinterpret_cast<T*>(&(e->storage))->~T();
             }
 
-            static void invalid(const std::size_t& tag, Self* e) {}
+            static void invalid(const std::size_t& tag, Layout* e) {}
         };
 
-        // Apply
+        // Copy Assignment
+        // When both sides hold the same variant its own assignment is used, 
+        // so the existing object can reuse its resources
         template<typename T, std::size_t n>
-        struct ApplyT {
-            template<typename F>
-            static auto call(Self* e, F f) {
-                return f(*reinterpret_cast<T*>(&(e->storage)));
+        struct CopyAssignT {
+            static void call(const Layout& from, Layout* to) {
+                if(to->tag == n) {
+                    assign(from, to, std::is_copy_assignable<T>(), NeverEmpty());
+                } else {
+                    replace(from, to, NeverEmpty());
+                }
             }
 
-            template<typename F>
-            static auto invalid(const std::size_t& tag, Self* e, F f) -> decltype(f(*(T*)nullptr)) {
-                #define VARIANT_ERROR_X(name, error, msg) case InvalidReason::name: throw error();
-                
-                switch(tag - e->variants) {
-                    VARIANT_ERROR_EXPAND
+            static void assign(const Layout& from, Layout* to, std::true_type, std::true_type) {
+                *reinterpret_cast<T*>(&(to->storage)) = *reinterpret_cast<const T*>(&(from.storage));
+            }
 
-                    default:
-                        throw UnknownVariantError();
+            static void assign(const Layout& from, Layout* to, std::true_type, std::false_type) {
+                guard(
+                    [&]() { *reinterpret_cast<T*>(&(to->storage)) = *reinterpret_cast<const T*>(&(from.storage)); },
+                    [&]() { 
+                        DestructorT<T, n>::call(to);
+                        to->tag = variants + InvalidReason::CopyThrew;
+                    }
+                );
+            }
+
+            template<typename NeverEmptyT>
+            static void assign(const Layout& from, Layout* to, std::false_type, NeverEmptyT never_empty) {
+                replace(from, to, never_empty);
+            }
+
+            // If the copy may throw, it is made before the old object is destroyed
+            static void replace(const Layout& from, Layout* to, std::true_type) {
+                replace(from, to, std::true_type(), std::is_nothrow_copy_constructible<T>());
+            }
+
+            static void replace(const Layout& from, Layout* to, std::true_type, std::true_type) {
+                Destructor::call(to->tag, to);
+                CopyConstructorT<T, n>::call(from, to);
+            }
+
+            static void replace(const Layout& from, Layout* to, std::true_type, std::false_type) {
+                T copy(*reinterpret_cast<const T*>(&(from.storage)));
+
+                Destructor::call(to->tag, to);
+                ::new (&(to->storage)) T(std::move(copy));
+                to->tag = n;
+            }
+
+            static void replace(const Layout& from, Layout* to, std::false_type) {
+                Destructor::call(to->tag, to);
+                CopyConstructorT<T, n>::call(from, to);
+            }
+
+            static void invalid(const std::size_t& tag, const Layout& from, Layout* to) {
+                Destructor::call(to->tag, to);
+                to->tag = from.tag;
+            }
+        };
+
+        // Move Assignment
+        template<typename T, std::size_t n>
+        struct MoveAssignT {
+            static void call(Layout&& from, Layout* to) {
+                if(to->tag == n) {
+                    assign(std::move(from), to, std::is_move_assignable<T>(), NeverEmpty());
+                } else {
+                    Destructor::call(to->tag, to);
+                    MoveConstructorT<T, n>::call(std::move(from), to);
                 }
+            }
 
-                #undef VARIANT_ERROR_X
+            // The source keeps its moved-from object
+            static void assign(Layout&& from, Layout* to, std::true_type, std::true_type) {
+                *reinterpret_cast<T*>(&(to->storage)) = std::move(*reinterpret_cast<T*>(&(from.storage)));
+            }
+
+            static void assign(Layout&& from, Layout* to, std::true_type, std::false_type) {
+                from.tag = variants + InvalidReason::MovedFrom;
+
+                guard(
+                    [&]() { *reinterpret_cast<T*>(&(to->storage)) = std::move(*reinterpret_cast<T*>(&(from.storage))); },
+                    [&]() { 
+                        DestructorT<T, n>::call(to);
+                        to->tag = variants + InvalidReason::MoveThrew;
+                    }
+                );
+
+                DestructorT<T, n>::call(&from);
+            }
+
+            template<typename NeverEmptyT>
+            static void assign(Layout&& from, Layout* to, std::false_type, NeverEmptyT) {
+                DestructorT<T, n>::call(to);
+                MoveConstructorT<T, n>::call(std::move(from), to);
+            }
+
+            static void invalid(const std::size_t& tag, Layout&& from, Layout* to) {
+                Destructor::call(to->tag, to);
+                to->tag = from.tag;
+                from.tag = variants + InvalidReason::MovedFrom;
             }
         };
 
-        // Match
-        template<typename T, std::size_t n, typename... Fs>
-        struct CallNth;
+        // Access the stored object with the value category of the enum
+        // A boxed variant gives the object in the box, or calls the policy's invalid if it is empty
+        template<typename T>
+        static typename Unbox<T>::type& value(Layout& e) {
+            return Unbox<T>::template get<Policy>(*reinterpret_cast<T*>(&(e.storage)));
+        }
 
-        template<typename T, std::size_t n, typename F, typename... Fs>
-        struct CallNth<T, n, F, Fs...> {
-            static auto call(T t, F f, Fs... fs) {
-                return CallNth<T, n - 1, Fs...>::call(t, std::forward<Fs>(fs)...);
+        template<typename T>
+        static const typename Unbox<T>::type& value(const Layout& e) {
+            return Unbox<T>::template get<Policy>(*reinterpret_cast<const T*>(&(e.storage)));
+        }
+
+        template<typename T>
+        static typename Unbox<T>::type&& value(Layout&& e) {
+            return std::move(Unbox<T>::template get<Policy>(*reinterpret_cast<T*>(&(e.storage))));
+        }
+
+        // Whether the stored object is an empty box
+        template<typename T>
+        static bool empty(const Layout& e) noexcept {
+            return Unbox<T>::empty(*reinterpret_cast<const T*>(&(e.storage)));
+        }
+
+        // Apply
+        template<typename T, std::size_t n>
+        struct ApplyT {
+            template<typename E, typename F>
+            static auto call(E&& e, F&& f) {
+                return std::forward<F>(f)(value<T>(std::forward<E>(e)));
             }
 
-            static auto invalid(const std::size_t& tag, F f, Fs... fs) {
-                return CallNth<T, n - 1, Fs...>::invalid(tag, std::forward<Fs>(fs)...);
+            template<typename E, typename F>
+            static auto invalid(const std::size_t& tag, E&& e, F&& f) 
+                -> decltype(std::forward<F>(f)(value<T>(std::forward<E>(e)))) {
+
+                Policy::invalid(reason(tag));
             }
         };
 
-        template<typename T, typename F, typename... Fs>
-        struct CallNth<T, 0, F, Fs...> {
-            static auto call(T t, F f, Fs... fs) {
-                return f(t);
+        // Match
+        // T is the reference type the stored object is passed to the handler as
+        // Hs is the tuple of handlers, so a call through the table passes one pointer
+        // however many variants there are, and picking the nth handler is a single
+        // lookup rather than a recursion per handler
+        template<typename T, std::size_t n, typename Hs>
+        struct CallNth {
+            template<std::size_t i>
+            using F = typename std::tuple_element<i, Hs>::type;
+
+            static auto call(T t, Hs&& hs) {
+                return std::forward<F<n>>(std::get<n>(hs))(std::forward<T>(t));
             }
 
-            static auto invalid(const std::size_t& tag, F f, Fs... fs) {
-                #define VARIANT_ERROR_X(name, error, msg) case InvalidReason::name: return f(error());
+            static auto invalid(const std::size_t& tag, Hs&& hs) {
+                #define VARIANT_ERROR_X(name, error, msg) case InvalidReason::name: return std::forward<F<n>>(std::get<n>(hs))(error());
 
                 switch(tag - variants) {
                     VARIANT_ERROR_EXPAND
 
                     default:
-                        return f(UnknownVariantError());
+                        return std::forward<F<n>>(std::get<n>(hs))(UnknownVariantError());
                 }
 
                 #undef VARIANT_ERROR_X
             }
         };
 
-        template<typename T, std::size_t n, bool no_check, typename... Fs>
+        template<typename T, std::size_t n, bool no_check, typename E, typename Hs>
         struct MatchTBase;
 
-        template<typename T, std::size_t n, typename... Fs>
-        struct MatchTBase<T, n, true, Fs...> {
-            static auto call(Self* e, Fs... fs) {
-                return CallNth<T, n, Fs...>::call(*reinterpret_cast<T*>(&(e->storage)), std::forward<Fs>(fs)...);
-            }
-
-            static auto invalid(const std::size_t& tag, Self* e, Fs... fs) 
-                -> decltype(CallNth<T, n, Fs...>::call(*(T*)nullptr, fs...)) {
+        template<typename T, std::size_t n, typename E, typename Hs>
+        struct MatchTBase<T, n, true, E, Hs> {
+            using Ref = decltype(value<T>(std::declval<E>()));
 
-                #define VARIANT_ERROR_X(name, error, msg) case InvalidReason::name: throw error();
-                
-                switch(tag - e->variants) {
-                    VARIANT_ERROR_EXPAND
+            static auto call(E&& e, Hs&& hs) {
+                return CallNth<Ref, n, Hs>::call(value<T>(std::forward<E>(e)), std::move(hs));
+            }
 
-                    default:
-                        throw UnknownVariantError();
-                }
+            static auto invalid(const std::size_t& tag, E&& e, Hs&& hs) 
+                -> decltype(CallNth<Ref, n, Hs>::call(value<T>(std::forward<E>(e)), std::move(hs))) {
 
-                #undef VARIANT_ERROR_X
+                Policy::invalid(reason(tag));
             }
         };
 
-        template<typename T, std::size_t n, typename... Fs>
-        struct MatchTBase<T, n, false, Fs...> {
-            static auto call(Self* e, Fs... fs) {
-                return CallNth<T, n, Fs...>::call(*reinterpret_cast<T*>(&(e->storage)), std::forward<Fs>(fs)...);
+        template<typename T, std::size_t n, typename E, typename Hs>
+        struct MatchTBase<T, n, false, E, Hs> {
+            using Ref = decltype(value<T>(std::declval<E>()));
+
+            // An empty box goes to the error handler, as an invalid tag does
+            static auto call(E&& e, Hs&& hs) {
+                if(empty<T>(e)) {
+                    return CallNth<Ref, variants, Hs>::invalid(variants + InvalidReason::MovedFrom, std::move(hs));
+                }
+
+                return CallNth<Ref, n, Hs>::call(value<T>(std::forward<E>(e)), std::move(hs));
             }
 
-            static auto invalid(const std::size_t& tag, Self* e, Fs... fs) {
-                return CallNth<T, variants, Fs...>::invalid(tag, std::forward<Fs>(fs)...);
+            static auto invalid(const std::size_t& tag, E&& e, Hs&& hs) {
+                return CallNth<Ref, variants, Hs>::invalid(tag, std::move(hs));
             }
         };
 
         template<typename T, std::size_t n>
         struct MatchT {
-            template<typename... Fs>
-            using Base = MatchTBase<T, n, sizeof...(Fs) == 1 + sizeof...(Variants), Fs...>;
+            template<typename E, typename Hs>
+            using Base = MatchTBase<T, n, std::tuple_size<Hs>::value == 1 + sizeof...(Variants), E, Hs>;
 
-            template<typename... Fs>
-            static auto call(Self* e, Fs... fs) {
-                return Base<Fs...>::call(e, std::forward<Fs>(fs)...);
+            template<typename E, typename Hs>
+            static auto call(E&& e, Hs&& hs) {
+                return Base<E, Hs>::call(std::forward<E>(e), std::move(hs));
             }
 
-            template<typename... Fs>
-            static auto invalid(const std::size_t& tag, Self* e, Fs... fs) {
-                return Base<Fs...>::invalid(tag, e, std::forward<Fs>(fs)...);
+            template<typename E, typename Hs>
+            static auto invalid(const std::size_t& tag, E&& e, Hs&& hs) {
+                return Base<E, Hs>::invalid(tag, std::forward<E>(e), std::move(hs));
             }
         };
     };
@@ -368,75 +849,165 @@ private:
         typename impl::template ConstructorT<std::is_constructible, std::is_constructible<VariantT, Args...>::value, 0, Args...>
     >::type;
 
-    using CopyConstructor = typename impl::template Helper<impl::template CopyConstructorT, const Self&, Self*>;
-    using MoveConstructor = typename impl::template Helper<impl::template MoveConstructorT, Self&&, Self*>;
-    using Destructor = typename impl::template Helper<impl::template DestructorT, Self*>;
+    using CopyConstructor = typename impl::template Helper<impl::template CopyConstructorT, const Layout&, Layout*>;
+    using MoveConstructor = typename impl::template Helper<impl::template MoveConstructorT, Layout&&, Layout*>;
+    using Destructor = typename impl::template DispatchT<impl::template DestructorT, variants + invalid_states, Layout*>;
+    using CopyAssign = typename impl::template Helper<impl::template CopyAssignT, const Layout&, Layout*>;
+    using MoveAssign = typename impl::template Helper<impl::template MoveAssignT, Layout&&, Layout*>;
 
+    // E is the qualified reference to the enum, F/Fs are forwarding references
+    template<typename E, typename F>
+    using Apply = typename impl::template Helper<impl::template ApplyT, E, F&&>;
+
+    // Handlers are held by reference, except for stateless temporaries (e.g. lambdas
+    // without captures), which are free to copy and take no space in the tuple
     template<typename F>
-    using Apply = typename impl::template Helper<impl::template ApplyT, Self*, F>;
+    using Handler = typename std::conditional<
+        !std::is_reference<F>::value && std::is_empty<F>::value && std::is_trivially_copyable<F>::value,
+        F, F&&
+    >::type;
 
     template<typename... Fs>
-    using Match = typename impl::template Helper<impl::template MatchT, Self*, Fs...>;
+    using Handlers = std::tuple<Handler<Fs>...>;
+
+    template<typename E, typename... Fs>
+    using Match = typename impl::template Helper<impl::template MatchT, E, Handlers<Fs...>&&>;
+
+    // Special member implementations, for when a variant is not trivial
+    static void copy_construct(const Layout& from, Layout* to) {
+        CopyConstructor::call(from.tag, from, to);
+    }
+
+    static void move_construct(Layout&& from, Layout* to) {
+        MoveConstructor::call(from.tag, std::move(from), to);
+    }
+
+    static void copy_assign(const Layout& from, Layout* to) {
+        if(&from != to) {
+            CopyAssign::call(from.tag, from, to);
+        }
+    }
 
-    std::size_t tag;
-    StorageT storage;
+    static void move_assign(Layout&& from, Layout* to) {
+        if(&from != to) {
+            MoveAssign::call(from.tag, std::move(from), to);
+        }
+    }
+
+    static void destroy(Layout* e) {
+        Destructor::call(e->tag, e);
+    }
+
+    // Emplace directly into the storage
+    template<std::size_t n, typename... Args>
+    typename VariantList::template Nth<n>& emplace_impl(std::true_type, Args&&... args) {
+        using T = typename VariantList::template Nth<n>;
+
+        Destructor::call(tag, this);
+        tag = variants + InvalidReason::EmplaceThrew;
+
+        T* t = ::new (&storage) T(std::forward<Args>(args)...);
+        tag = n;
+
+        return *t;
+    }
+
+    // Emplace through a temporary, so a throw leaves the enum as it was
+    template<std::size_t n, typename... Args>
+    typename VariantList::template Nth<n>& emplace_impl(std::false_type, Args&&... args) {
+        using T = typename VariantList::template Nth<n>;
+
+        T temporary(std::forward<Args>(args)...);
+        Destructor::call(tag, this);
 
-    // Private default constructor, for construct<T>
-    EnumT() : storage() {}
+        T* t = ::new (&storage) T(std::move(temporary));
+        tag = n;
+
+        return *t;
+    }
 
 public:
     template<typename T>
-    using Variant = EnumT<VariantT, Variants..., T>;
+    using Variant = BasicEnumT<Policy, VariantT, Variants..., T>;
 
     template<typename T, typename... Args>
     static Self construct(Args&&... args) {
-        EnumT ret;
-        ret.tag = IndexOf<T, VariantT, Variants...>::value;
-        ::new (&(ret.storage)) T(std::forward<Args>(args)...);
-        return ret;
+        return Self(InPlace<T>(), std::forward<Args>(args)...);
     }
 
-    template<typename... Args>
-    EnumT(Args&&... args) {
+    template<typename... Args, typename = typename std::enable_if<!IsCopyOf<Self, Args...>::value>::type>
+    BasicEnumT(Args&&... args) {
         Constructor<Args...>::construct(this, std::forward<Args>(args)...);
     }
 
-    EnumT(const Self& other) noexcept {
-        CopyConstructor::call(other.tag, std::forward<Self>(other), this);
-    }
+    // Construct the variant T in place
+    template<typename T, typename... Args>
+    explicit BasicEnumT(InPlace<T>, Args&&... args) 
+        : BasicEnumT(InPlaceIndex<IndexOf<T, VariantT, Variants...>::value>(), std::forward<Args>(args)...) {}
 
-    EnumT(Self&& other) noexcept {
-        MoveConstructor::call(other.tag, std::forward<Self>(other), this);
+    // Construct the nth variant in place
+    template<std::size_t n, typename... Args>
+    explicit BasicEnumT(InPlaceIndex<n>, Args&&... args) {
+        using T = typename VariantList::template Nth<n>;
+
+        ::new (&storage) T(std::forward<Args>(args)...);
+        tag = n;
     }
 
-    EnumT& operator=(const Self& other) noexcept {
-        if(this->tag != other.tag) {
-            Destructor::call(this->tag, this);
-        }
+    BasicEnumT(const Self& other) = default;
+    BasicEnumT(Self&& other) = default;
 
-        CopyConstructor::call(other.tag, std::forward<Self>(other), this);
-        return *this;
+    BasicEnumT& operator=(const Self& other) = default;
+    BasicEnumT& operator=(Self&& other) = default;
+
+    // Replace the contained object with a T constructed in place
+    template<typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        return emplace<IndexOf<T, VariantT, Variants...>::value>(std::forward<Args>(args)...);
     }
 
-    EnumT& operator=(Self&& other) noexcept {
-        if(this->tag != other.tag) {
-            Destructor::call(this->tag, this);
-        }
+    // Replace the contained object with the nth variant constructed in place
+    // If the constructor throws, the variant is left invalid, or unchanged if it is never empty
+    template<std::size_t n, typename... Args>
+    typename VariantList::template Nth<n>& emplace(Args&&... args) {
+        using T = typename VariantList::template Nth<n>;
+        using Direct = std::integral_constant<bool, !never_empty || std::is_nothrow_constructible<T, Args...>::value>;
 
-        MoveConstructor::call(other.tag, std::forward<Self>(other), this);
-        return *this;
+        return emplace_impl<n>(Direct(), std::forward<Args>(args)...);
     }
 
     // Apply the object to a polymorphic function
+    // The object is passed by reference, and moved from on an rvalue enum
+    template<typename F>
+    auto apply(F&& f) & {
+        return Apply<Self&, F>::call(this->tag, *this, std::forward<F>(f));
+    }
+
     template<typename F>
-    auto apply(F f) {
-        return Apply<F>::call(this->tag, this, std::forward<F>(f));
+    auto apply(F&& f) const& {
+        return Apply<const Self&, F>::call(this->tag, *this, std::forward<F>(f));
+    }
+
+    template<typename F>
+    auto apply(F&& f) && {
+        return Apply<Self&&, F>::call(this->tag, std::move(*this), std::forward<F>(f));
     }
 
     // Apply to a function based on the contained type
+    // The object is passed by reference, and moved from on an rvalue enum
+    template<typename... Fs>
+    auto match(Fs&&... fs) & {
+        return Match<Self&, Fs...>::call(this->tag, *this, Handlers<Fs...>(std::forward<Fs>(fs)...));
+    }
+
     template<typename... Fs>
-    auto match(Fs... fs) {
-        return Match<Fs...>::call(this->tag, this, std::forward<Fs>(fs)...);
+    auto match(Fs&&... fs) const& {
+        return Match<const Self&, Fs...>::call(this->tag, *this, Handlers<Fs...>(std::forward<Fs>(fs)...));
+    }
+
+    template<typename... Fs>
+    auto match(Fs&&... fs) && {
+        return Match<Self&&, Fs...>::call(this->tag, std::move(*this), Handlers<Fs...>(std::forward<Fs>(fs)...));
     }
 
     // Returns the identifying tag
@@ -450,14 +1021,34 @@ public:
         return tag == IndexOf<T, VariantT, Variants...>::value;
     }
 
-    // Returns the object as the specified type, or throws
+    // Returns the object as the specified type, or calls the policy's bad_access (which throws by default)
     template<typename T>
     T& get() {
-        if(tag == IndexOf<T, VariantT, Variants...>::value) {
-            return *reinterpret_cast<T*>(&storage);
-        } else {
-            throw std::runtime_error("Attempted get<T> on incorrect type");
+        if(tag != IndexOf<T, VariantT, Variants...>::value) {
+            Policy::bad_access();
+        }
+
+        return *reinterpret_cast<T*>(&storage);
+    }
+
+    template<typename T>
+    const T& get() const {
+        if(tag != IndexOf<T, VariantT, Variants...>::value) {
+            Policy::bad_access();
         }
+
+        return *reinterpret_cast<const T*>(&storage);
+    }
+
+    // Returns a pointer to the object if it is of the specified type, or nullptr
+    template<typename T>
+    T* try_get() noexcept {
+        return tag == IndexOf<T, VariantT, Variants...>::value ? reinterpret_cast<T*>(&storage) : nullptr;
+    }
+
+    template<typename T>
+    const T* try_get() const noexcept {
+        return tag == IndexOf<T, VariantT, Variants...>::value ? reinterpret_cast<const T*>(&storage) : nullptr;
     }
 
     // I don't recommend this function
@@ -468,7 +1059,13 @@ public:
 
     // Returns true if the variant is valid
     bool valid() const noexcept {
-        return tag < variants;
+        return never_empty || tag < variants;
+    }
+
+    // Returns the reason the variant is invalid
+    // Only meaningful if the variant is not valid
+    InvalidReason reason() const noexcept {
+        return impl::reason(tag);
     }
 
     // Returns true if the variant is valid
@@ -476,18 +1073,206 @@ public:
         return valid();
     }
 
-    ~EnumT() {
-        Destructor::call(this->tag, this);
+    ~BasicEnumT() = default;
+};
+
+template<typename... Variants>
+using EnumT = BasicEnumT<DefaultPolicy, Variants...>;
+
+// True if F can be called with just an error, to handle invalid variants
+template<typename F, typename = void>
+struct HandlesInvalid : public std::false_type {};
+
+template<typename F>
+struct HandlesInvalid<F, decltype(std::declval<F>()(std::declval<const InvalidVariantError&>()), void())> 
+    : public std::true_type {};
+
+// Shape of the flattened table for multiple dispatch
+// Each enum contributes its variants followed by its invalid states
+template<typename... Es>
+struct MultiMatchTable {
+    static constexpr std::size_t enums = sizeof...(Es);
+
+    static constexpr std::size_t states(std::size_t i) {
+        const std::size_t states[] = { Es::states... };
+        return states[i];
+    }
+
+    static constexpr std::size_t variants(std::size_t i) {
+        const std::size_t variants[] = { Es::variants... };
+        return variants[i];
+    }
+
+    // Distance in the table between consecutive tags of the ith enum
+    static constexpr std::size_t stride(std::size_t i) {
+        std::size_t result = 1;
+
+        for(std::size_t j = i + 1; j < enums; ++j) {
+            result *= states(j);
+        }
+
+        return result;
+    }
+
+    static constexpr std::size_t size() {
+        return stride(0) * states(0);
+    }
+
+    // Tag of the ith enum at a table index
+    static constexpr std::size_t tag(std::size_t index, std::size_t i) {
+        return index / stride(i) % states(i);
+    }
+
+    // Returns true if every tag at a table index is a valid variant
+    static constexpr bool valid(std::size_t index) {
+        for(std::size_t i = 0; i < enums; ++i) {
+            if(tag(index, i) >= variants(i)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // First enum with an invalid tag at a table index
+    static constexpr std::size_t first_invalid(std::size_t index) {
+        for(std::size_t i = 0; i < enums; ++i) {
+            if(tag(index, i) >= variants(i)) {
+                return i;
+            }
+        }
+
+        return 0;
+    }
+
+    // Reason for the first invalid tag at a table index
+    static constexpr std::size_t reason(std::size_t index) {
+        return tag(index, first_invalid(index)) - variants(first_invalid(index));
+    }
+
+    // Table index for the tags of each enum
+    static std::size_t index(std::initializer_list<std::size_t> tags) {
+        std::size_t result = 0;
+        std::size_t i = 0;
+
+        for(auto tag : tags) {
+            result += std::min(tag, states(i) - 1) * stride(i);
+            ++i;
+        }
+
+        return result;
+    }
+};
+
+// Multiple dispatch
+template<typename F, typename... Es>
+struct MultiMatchT {
+    using Table = MultiMatchTable<typename std::decay<Es>::type...>;
+
+    template<std::size_t i>
+    using Enum = typename TypeList<typename std::decay<Es>::type...>::template Nth<i>;
+
+    template<std::size_t i, std::size_t n>
+    using Variant = typename Enum<i>::VariantList::template Nth<n>;
+
+    template<std::size_t index>
+    struct ValidT {
+        template<std::size_t... is>
+        static auto call(std::index_sequence<is...>, F&& f, Es&&... es) {
+            return std::forward<F>(f)(
+                Enum<is>::impl::template value<Variant<is, Table::tag(index, is)>>(std::forward<Es>(es))...
+            );
+        }
+
+        // Whether any of the enums holds an empty box
+        template<std::size_t... is>
+        static bool empty(std::index_sequence<is...>, const Es&... es) {
+            bool boxes[] = { false, Enum<is>::impl::template empty<Variant<is, Table::tag(index, is)>>(es)... };
+
+            bool any = false;
+            for(bool box : boxes) {
+                any = any || box;
+            }
+
+            return any;
+        }
+    };
+
+    using Result = decltype(ValidT<0>::call(std::index_sequence_for<Es...>(), std::declval<F>(), std::declval<Es>()...));
+    using Fn = Result (*)(F&&, Es&&...);
+
+    template<std::size_t index, bool valid = Table::valid(index)>
+    struct Entry {
+        static Result call(F&& f, Es&&... es) {
+            return call(HandlesInvalid<F>(), std::forward<F>(f), std::forward<Es>(es)...);
+        }
+
+        // An empty box goes to the error handler, as an invalid tag does
+        static Result call(std::true_type, F&& f, Es&&... es) {
+            if(ValidT<index>::empty(std::index_sequence_for<Es...>(), es...)) {
+                return std::forward<F>(f)(VariandMovedFrom());
+            }
+
+            return call(std::false_type(), std::forward<F>(f), std::forward<Es>(es)...);
+        }
+
+        static Result call(std::false_type, F&& f, Es&&... es) {
+            return ValidT<index>::call(std::index_sequence_for<Es...>(), std::forward<F>(f), std::forward<Es>(es)...);
+        }
+    };
+
+    template<std::size_t index>
+    struct Entry<index, false> {
+        static Result call(F&& f, Es&&... es) {
+            return invalid(HandlesInvalid<F>(), std::forward<F>(f));
+        }
+
+        static Result invalid(std::true_type, F&& f) {
+            #define VARIANT_ERROR_X(name, error, msg) case InvalidReason::name: return std::forward<F>(f)(error());
+
+            switch(Table::reason(index)) {
+                VARIANT_ERROR_EXPAND
+
+                default:
+                    return std::forward<F>(f)(UnknownVariantError());
+            }
+
+            #undef VARIANT_ERROR_X
+        }
+
+        static Result invalid(std::false_type, F&& f) {
+            using Policy = typename Enum<Table::first_invalid(index)>::Policy;
+            Policy::invalid(invalid_reason(Table::reason(index)));
+        }
+    };
+
+    template<std::size_t... ns>
+    static Result call(std::index_sequence<ns...>, F&& f, Es&&... es) {
+        static constexpr Fn table[] = { &Entry<ns>::call... };
+        return table[Table::index({ es.which()... })](std::forward<F>(f), std::forward<Es>(es)...);
+    }
+
+    static Result call(F&& f, Es&&... es) {
+        return call(std::make_index_sequence<Table::size()>(), std::forward<F>(f), std::forward<Es>(es)...);
     }
 };
 
+// Apply a polymorphic function to the objects in several enums at once
+// If any of them is invalid, f is called with the error if it can be, otherwise the policy's invalid is called
+template<typename F, typename E, typename... Es>
+auto match(F&& f, E&& e, Es&&... es) {
+    return MultiMatchT<F, E, Es...>::call(std::forward<F>(f), std::forward<E>(e), std::forward<Es>(es)...);
+}
 
-class Enum {
+template<typename Policy>
+class BasicEnum {
 public:
     template<typename T>
-    using Variant = EnumT<T>;
+    using Variant = BasicEnumT<Policy, T>;
 };
 
+using Enum = BasicEnum<DefaultPolicy>;
+
 }
 
 #undef VARIANT_ERROR_EXPAND
@@ -0,0 +1,213 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/message_queue.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_MESSAGE_QUEUE_HPP
+#define ENUM_MESSAGE_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "enum.hpp"
+
+namespace venum {
+
+// A bounded queue of EnumT<Ts...> messages for any number of producer threads and one consumer
+//
+// Messages are built in place in a ring of slots allocated up front, and handled and
+// destroyed in place by drain, so they are never copied or moved on the way through.
+// No locks are taken: each slot has a sequence number, which producers claim slots against
+// by bumping the tail, and which says when the message in it is ready or has been handled.
+template<typename... Ts>
+class MessageQueue {
+public:
+    using Enum = EnumT<Ts...>;
+
+    // Capacity is rounded up to a power of two
+    explicit MessageQueue(std::size_t capacity) : mask(round_up(capacity) - 1), slots(new Slot[mask + 1]) {
+        for(std::size_t i = 0; i <= mask; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MessageQueue(const MessageQueue&) = delete;
+    MessageQueue& operator=(const MessageQueue&) = delete;
+
+    // Messages never drained are destroyed without being handled
+    ~MessageQueue() {
+        for(;;) {
+            Slot& slot = slots[head & mask];
+
+            if(slot.sequence.load(std::memory_order_acquire) != head + 1) {
+                break;
+            }
+
+            if(slot.full) {
+                slot.message()->~Enum();
+            }
+
+            ++head;
+        }
+    }
+
+    // Builds a T in the next free slot, returning false if the queue is full
+    // Safe to call from any thread
+    template<typename T, typename... Args>
+    bool try_emplace(Args&&... args) {
+        std::size_t position = tail.value.load(std::memory_order_relaxed);
+        Slot* slot;
+
+        for(;;) {
+            slot = &slots[position & mask];
+            std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+            if(difference == 0) {
+                if(tail.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(difference < 0) {
+                return false;
+            } else {
+                position = tail.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        // If building the message throws, the slot is still handed on, marked empty,
+        // so the consumer doesn't wait on it forever
+        Publish publish{ *slot, position };
+        new (&slot->storage) Enum(InPlace<T>(), std::forward<Args>(args)...);
+        publish.slot.full = true;
+
+        return true;
+    }
+
+    // As try_emplace, but waits for a free slot when the queue is full
+    template<typename T, typename... Args>
+    void emplace(Args&&... args) {
+        while(!try_emplace<T>(std::forward<Args>(args)...)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Calls the matching handler on each message that is ready, in order, then destroys it
+    // Only the consumer thread may drain. Returns the number of messages handled, which
+    // is 0 if none were ready.
+    template<typename... Fs>
+    std::size_t drain(Fs&&... fs) {
+        return drain_at_most(mask + 1, std::forward<Fs>(fs)...);
+    }
+
+    // As drain, handling no more than max messages, so a consumer can check for other work between batches
+    template<typename... Fs>
+    std::size_t drain_at_most(std::size_t max, Fs&&... fs) {
+        std::size_t handled = 0;
+
+        while(handled < max) {
+            Slot& slot = slots[head & mask];
+
+            if(slot.sequence.load(std::memory_order_acquire) != head + 1) {
+                break;
+            }
+
+            // Releases the slot even if a handler throws
+            Release release{ slot, head + mask + 1 };
+            ++head;
+
+            if(slot.full) {
+                slot.message()->match(fs...);
+                ++handled;
+            }
+        }
+
+        return handled;
+    }
+
+    std::size_t capacity() const noexcept {
+        return mask + 1;
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        bool full = false;
+        typename std::aligned_storage<sizeof(Enum), alignof(Enum)>::type storage;
+
+        Enum* message() {
+            return reinterpret_cast<Enum*>(&storage);
+        }
+    };
+
+    // Marks a claimed slot as ready for the consumer
+    struct Publish {
+        ~Publish() {
+            slot.sequence.store(position + 1, std::memory_order_release);
+        }
+
+        Slot& slot;
+        std::size_t position;
+    };
+
+    // Destroys a handled message and gives its slot back to the producers
+    struct Release {
+        ~Release() {
+            if(slot.full) {
+                slot.message()->~Enum();
+                slot.full = false;
+            }
+
+            slot.sequence.store(next, std::memory_order_release);
+        }
+
+        Slot& slot;
+        std::size_t next;
+    };
+
+    // The tail is written by every producer, so it gets a cache line of its own,
+    // away from what the consumer and producers only read
+    struct Tail {
+        char before[64];
+        std::atomic<std::size_t> value{ 0 };
+        char after[64 - sizeof(std::atomic<std::size_t>)];
+    };
+
+    static std::size_t round_up(std::size_t capacity) {
+        std::size_t size = 2;
+        while(size < capacity) {
+            size *= 2;
+        }
+
+        return size;
+    }
+
+    const std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+
+    Tail tail;
+
+    // Only touched by the consumer
+    std::size_t head = 0;
+};
+
+}
+
+#endif
@@ -21,12 +21,167 @@
 
 #include "enum.hpp"
 
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 struct None {};
 
+// Niches
+// A niche is a value of T that can stand for None, so the Optional needs no tag.
+// Specialise this for a type with a spare value (a sentinel), giving:
+//   static constexpr bool value = true;
+//   static T none();                 // the sentinel
+//   static bool is_none(const T& t); // whether t is the sentinel
+// Note that Some(sentinel) is then indistinguishable from None.
+template<typename T, typename = void>
+struct NicheTraits {
+    static constexpr bool value = false;
+};
+
+// A null pointer is None
 template<typename T>
-using OptionalBase = venum::Enum::Variant<::None>::Variant<T>;
+struct NullNiche {
+    static constexpr bool value = true;
+
+    static T none() noexcept {
+        return nullptr;
+    }
+
+    static bool is_none(const T& t) noexcept {
+        return t == nullptr;
+    }
+};
+
+template<typename T>
+struct NicheTraits<T*> : NullNiche<T*> {};
+
+template<typename T>
+struct NicheTraits<std::shared_ptr<T>> : NullNiche<std::shared_ptr<T>> {};
+
+template<typename T, typename D>
+struct NicheTraits<std::unique_ptr<T, D>> : NullNiche<std::unique_ptr<T, D>> {};
+
+// Holds just a T, with the niche as None
+// Has the same match/apply interface as the enum it replaces
+template<typename T>
+class NicheOptionalBase {
+public:
+    using Niche = NicheTraits<T>;
+
+    NicheOptionalBase(::None) : payload(Niche::none()) {}
+
+    template<typename... Args>
+    NicheOptionalBase(venum::InPlace<T>, Args&&... args) : payload(std::forward<Args>(args)...) {}
+
+    template<typename... Args, typename = std::enable_if_t<std::is_constructible<T, Args...>::value>>
+    NicheOptionalBase(Args&&... args) : payload(std::forward<Args>(args)...) {}
+
+    // The result type comes from the None handler, as with the enum
+    template<typename FNone, typename FSome>
+    auto match(FNone&& f_none, FSome&& f_some) & -> decltype(std::forward<FNone>(f_none)(std::declval<::None&>())) {
+        ::None none;
+
+        if(Niche::is_none(payload)) {
+            return std::forward<FNone>(f_none)(none);
+        }
+
+        return std::forward<FSome>(f_some)(payload);
+    }
+
+    template<typename FNone, typename FSome>
+    auto match(FNone&& f_none, FSome&& f_some) const& -> decltype(std::forward<FNone>(f_none)(std::declval<const ::None&>())) {
+        const ::None none{};
+
+        if(Niche::is_none(payload)) {
+            return std::forward<FNone>(f_none)(none);
+        }
+
+        return std::forward<FSome>(f_some)(payload);
+    }
+
+    template<typename FNone, typename FSome>
+    auto match(FNone&& f_none, FSome&& f_some) && -> decltype(std::forward<FNone>(f_none)(std::declval<::None&&>())) {
+        if(Niche::is_none(payload)) {
+            return std::forward<FNone>(f_none)(::None{});
+        }
+
+        return std::forward<FSome>(f_some)(std::move(payload));
+    }
+
+    // A trailing error handler is accepted, as the enum takes one, but there is no invalid state to call it for
+    template<typename FNone, typename FSome, typename FError>
+    auto match(FNone&& f_none, FSome&& f_some, FError&&) & {
+        static_assert(venum::HandlesInvalid<FError>::value, "the error handler must take an InvalidVariantError");
+        return match(std::forward<FNone>(f_none), std::forward<FSome>(f_some));
+    }
+
+    template<typename FNone, typename FSome, typename FError>
+    auto match(FNone&& f_none, FSome&& f_some, FError&&) const& {
+        static_assert(venum::HandlesInvalid<FError>::value, "the error handler must take an InvalidVariantError");
+        return match(std::forward<FNone>(f_none), std::forward<FSome>(f_some));
+    }
+
+    template<typename FNone, typename FSome, typename FError>
+    auto match(FNone&& f_none, FSome&& f_some, FError&&) && {
+        static_assert(venum::HandlesInvalid<FError>::value, "the error handler must take an InvalidVariantError");
+        return std::move(*this).match(std::forward<FNone>(f_none), std::forward<FSome>(f_some));
+    }
+
+    template<typename F>
+    auto apply(F&& f) & {
+        return match(f, f);
+    }
+
+    template<typename F>
+    auto apply(F&& f) const& {
+        return match(f, f);
+    }
+
+    template<typename F>
+    auto apply(F&& f) && {
+        return std::move(*this).match(f, f);
+    }
+
+    std::size_t which() const noexcept {
+        return Niche::is_none(payload) ? 0 : 1;
+    }
+
+    template<typename U>
+    bool contains() const noexcept {
+        static_assert(std::is_same<U, T>::value || std::is_same<U, ::None>::value, "contains on an optional takes None or the value type");
+        return std::is_same<U, ::None>::value == Niche::is_none(payload);
+    }
+
+    // Only T can be got at, there is no stored None
+    template<typename U>
+    U* try_get() noexcept {
+        static_assert(std::is_same<U, T>::value, "try_get on a niche optional takes the value type");
+        return Niche::is_none(payload) ? nullptr : &payload;
+    }
+
+    template<typename U>
+    const U* try_get() const noexcept {
+        static_assert(std::is_same<U, T>::value, "try_get on a niche optional takes the value type");
+        return Niche::is_none(payload) ? nullptr : &payload;
+    }
+
+    bool valid() const noexcept {
+        return true;
+    }
+
+protected:
+    T payload;
+};
+
+// Uses the niche if T has one, and an enum with a tag otherwise
+template<typename T>
+using OptionalBase = typename std::conditional<
+    NicheTraits<T>::value,
+    NicheOptionalBase<T>,
+    venum::Enum::Variant<::None>::Variant<T>
+>::type;
 
 template<typename T>
 class Optional : public OptionalBase<T> {
@@ -34,49 +189,144 @@ public:
     using ValueType = T;
 
     static Optional<T> Some(T t) {
-        return Optional(t);
+        return Optional(std::move(t));
     }
 
     static Optional<T> None() {
         return Optional(::None{});
     }
 
-    explicit operator bool() {
-        return this->match(
-            [](::None) { return false; },
-            [](T) { return true; }
-        );
+    // Only checks the tag (or niche)
+    bool has_value() const noexcept {
+        return this->template contains<T>();
+    }
+
+    explicit operator bool() const noexcept {
+        return has_value();
+    }
+
+    // Returns a reference to the value, throwing if there is none
+    // (or calling the default policy's bad_access when exceptions are disabled)
+    T& value() & {
+        return *checked(this->template try_get<T>());
+    }
+
+    const T& value() const& {
+        return *checked(this->template try_get<T>());
     }
 
-    T get() {
-        return this->match(
-            [](::None) -> T { throw std::runtime_error("Error: attempted get() on Optional::None"); },
-            [](T t) { return t; }
-        );
+    T&& value() && {
+        return std::move(*checked(this->template try_get<T>()));
     }
 
+    // Unchecked access, the Optional must hold a value
+    T& operator*() & {
+        return *this->template try_get<T>();
+    }
+
+    const T& operator*() const& {
+        return *this->template try_get<T>();
+    }
+
+    T&& operator*() && {
+        return std::move(*this->template try_get<T>());
+    }
+
+    T* operator->() {
+        return this->template try_get<T>();
+    }
+
+    const T* operator->() const {
+        return this->template try_get<T>();
+    }
+
+    T get() const {
+        return value();
+    }
+
+    template<typename U>
+    T value_or(U&& fallback) const& {
+        return has_value() ? **this : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    template<typename U>
+    T value_or(U&& fallback) && {
+        return has_value() ? std::move(**this) : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    // Calls f with the value, if there is one, and wraps the result
+    // The && versions pass the value on as an rvalue, so a chain of them need not copy it
     template<typename F>
-    auto map(F f) {
-        using U = decltype(f(get()));
+    auto map(F&& f) & {
+        return map_impl(*this, std::forward<F>(f));
+    }
 
-        return this->match(
-            [](::None) { return Optional<U>::None(); },
-            [&f](T t) { return Optional<U>::Some(f(t)); }
-        );
+    template<typename F>
+    auto map(F&& f) const& {
+        return map_impl(*this, std::forward<F>(f));
     }
 
     template<typename F>
-    auto and_then(F f) {
-        using U = typename decltype(f(get()))::ValueType;
+    auto map(F&& f) && {
+        return map_impl(std::move(*this), std::forward<F>(f));
+    }
 
-        return this->match(
-            [](::None) { return Optional<U>::None(); },
-            [&f](T t) { return f(t); }
-        );
+    // Calls f, which returns an Optional, with the value if there is one
+    template<typename F>
+    auto and_then(F&& f) & {
+        return and_then_impl(*this, std::forward<F>(f));
     }
 
-    template<typename... Args>
-    Optional(Args... args) : OptionalBase<T>(std::forward<Args>(args)...) {}
+    template<typename F>
+    auto and_then(F&& f) const& {
+        return and_then_impl(*this, std::forward<F>(f));
+    }
+
+    template<typename F>
+    auto and_then(F&& f) && {
+        return and_then_impl(std::move(*this), std::forward<F>(f));
+    }
+
+    // Optional(venum::InPlace<T>(), args...) builds the value in place from args
+    template<typename... Args, typename = std::enable_if_t<!venum::IsCopyOf<Optional, Args...>::value>>
+    Optional(Args&&... args) : OptionalBase<T>(std::forward<Args>(args)...) {}
+
+private:
+    template<typename P>
+    static P checked(P p) {
+        if(!p) {
+        #if VENUM_EXCEPTIONS
+            throw std::runtime_error("Error: attempted get() on Optional::None");
+        #else
+            venum::DefaultPolicy::bad_access();
+        #endif
+        }
+
+        return p;
+    }
+
+    // O is the qualified Optional, so *o is the value with the same qualification
+    template<typename O, typename F>
+    static auto map_impl(O&& o, F&& f) {
+        using U = std::decay_t<decltype(std::forward<F>(f)(*std::forward<O>(o)))>;
+
+        if(!o.has_value()) {
+            return Optional<U>::None();
+        }
+
+        return Optional<U>::Some(std::forward<F>(f)(*std::forward<O>(o)));
+    }
+
+    template<typename O, typename F>
+    static auto and_then_impl(O&& o, F&& f) {
+        using R = std::decay_t<decltype(std::forward<F>(f)(*std::forward<O>(o)))>;
+
+        if(!o.has_value()) {
+            return R::None();
+        }
+
+        return std::forward<F>(f)(*std::forward<O>(o));
+    }
 };
 
 #endif
@@ -0,0 +1,333 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/persistent_tree.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_PERSISTENT_TREE_HPP
+#define ENUM_PERSISTENT_TREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "optional.hpp"
+#include "tree.hpp"
+
+// Nodes of an AVL tree that never change once linked in
+//
+// Inserting or erasing copies the path from the root down to the change and
+// returns the new root, while the old root still reaches the tree as it was.
+// Unchanged subtrees are shared between the two, so each version costs O(log n) new nodes.
+//
+// The writer passed to insert and erase makes the new nodes, and is told of each
+// node the new version no longer uses, which older versions may still need:
+//   NodeType make(T data, Link lhs, Link rhs)
+//   void retire(const NodeType& node)
+template<typename T, typename Storage>
+class PersistentNode {
+public:
+    using NodeType = typename Storage::template Pointer<PersistentNode<T, Storage>>;
+    using Link = Optional<NodeType>;
+    using Allocator = typename Storage::template Allocator<PersistentNode<T, Storage>>;
+
+    class Iterator;
+
+    PersistentNode(T data, Link lhs, Link rhs)
+        : data(std::move(data)), h(1 + std::max(height(lhs), height(rhs))), lhs(std::move(lhs)), rhs(std::move(rhs)) {}
+
+    template<typename Writer>
+    static NodeType insert(Writer& writer, const Link& link, T data) {
+        if(!link.has_value()) {
+            return writer.make(std::move(data), Link::None(), Link::None());
+        }
+
+        const NodeType& node = *link;
+        writer.retire(node);
+
+        if(data < node->data) {
+            return balance(writer, node->data, Link::Some(insert(writer, node->lhs, std::move(data))), node->rhs);
+        }
+
+        return balance(writer, node->data, node->lhs, Link::Some(insert(writer, node->rhs, std::move(data))));
+    }
+
+    // Returns the link unchanged, and leaves erased false, if t is not below it
+    template<typename Writer>
+    static Link erase(Writer& writer, const Link& link, const T& t, bool& erased) {
+        if(!link.has_value()) {
+            return Link::None();
+        }
+
+        const NodeType& node = *link;
+
+        if(t < node->data || node->data < t) {
+            bool left = t < node->data;
+            Link updated = erase(writer, left ? node->lhs : node->rhs, t, erased);
+
+            if(!erased) {
+                return link;
+            }
+
+            writer.retire(node);
+            return Link::Some(left
+                ? balance(writer, node->data, std::move(updated), node->rhs)
+                : balance(writer, node->data, node->lhs, std::move(updated)));
+        }
+
+        erased = true;
+        writer.retire(node);
+
+        if(!node->lhs.has_value()) {
+            return node->rhs;
+        }
+
+        if(!node->rhs.has_value()) {
+            return node->lhs;
+        }
+
+        // With two children, the next node's value takes this one's place
+        NodeType next = node;
+        Link rhs = erase_min(writer, node->rhs, next);
+        return Link::Some(balance(writer, next->data, node->lhs, std::move(rhs)));
+    }
+
+    static bool contains(const Link& root, const T& t) {
+        const Link* link = &root;
+
+        while(link->has_value()) {
+            const PersistentNode* node = get(*link);
+
+            if(t == node->data) {
+                return true;
+            }
+
+            link = t < node->data ? &node->lhs : &node->rhs;
+        }
+
+        return false;
+    }
+
+    static const PersistentNode* get(const Link& link) {
+        return link.has_value() ? &**link : nullptr;
+    }
+
+    static int height(const Link& link) {
+        return link.has_value() ? (*link)->h : 0;
+    }
+
+    T data;
+    int h;
+    Link lhs, rhs;
+
+private:
+    // Removes the leftmost node below link, which is returned in min
+    template<typename Writer>
+    static Link erase_min(Writer& writer, const Link& link, NodeType& min) {
+        const NodeType& node = *link;
+        writer.retire(node);
+
+        if(!node->lhs.has_value()) {
+            min = node;
+            return node->rhs;
+        }
+
+        return Link::Some(balance(writer, node->data, erase_min(writer, node->lhs, min), node->rhs));
+    }
+
+    // A new node over lhs and rhs, rotated if their heights differ by more than one
+    // Rather than rotating nodes in place, the nodes a rotation would change are rebuilt
+    template<typename Writer>
+    static NodeType balance(Writer& writer, const T& data, Link lhs, Link rhs) {
+        int balance = height(lhs) - height(rhs);
+
+        if(balance > 1) {
+            NodeType l = *lhs;
+            writer.retire(l);
+
+            if(height(l->lhs) >= height(l->rhs)) {
+                return writer.make(l->data, l->lhs, Link::Some(writer.make(data, l->rhs, std::move(rhs))));
+            }
+
+            NodeType lr = *l->rhs;
+            writer.retire(lr);
+
+            return writer.make(lr->data,
+                Link::Some(writer.make(l->data, l->lhs, lr->lhs)),
+                Link::Some(writer.make(data, lr->rhs, std::move(rhs))));
+        }
+
+        if(balance < -1) {
+            NodeType r = *rhs;
+            writer.retire(r);
+
+            if(height(r->rhs) >= height(r->lhs)) {
+                return writer.make(r->data, Link::Some(writer.make(data, std::move(lhs), r->lhs)), r->rhs);
+            }
+
+            NodeType rl = *r->lhs;
+            writer.retire(rl);
+
+            return writer.make(rl->data,
+                Link::Some(writer.make(data, std::move(lhs), rl->lhs)),
+                Link::Some(writer.make(r->data, rl->rhs, r->rhs)));
+        }
+
+        return writer.make(data, std::move(lhs), std::move(rhs));
+    }
+};
+
+// Forward in-order iterator
+// Nodes have no parent pointers, as they are shared between versions,
+// so it keeps the path of nodes still to visit
+template<typename T, typename Storage>
+class PersistentNode<T, Storage>::Iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    Iterator() = default;
+
+    explicit Iterator(const Link& root) {
+        descend(get(root));
+    }
+
+    reference operator*() const {
+        return path.back()->data;
+    }
+
+    pointer operator->() const {
+        return &path.back()->data;
+    }
+
+    Iterator& operator++() {
+        const PersistentNode* node = path.back();
+        path.pop_back();
+        descend(get(node->rhs));
+        return *this;
+    }
+
+    Iterator operator++(int) {
+        Iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    bool operator==(const Iterator& other) const {
+        return current() == other.current();
+    }
+
+    bool operator!=(const Iterator& other) const {
+        return current() != other.current();
+    }
+
+private:
+    void descend(const PersistentNode* node) {
+        for(; node; node = get(node->lhs)) {
+            path.push_back(node);
+        }
+    }
+
+    const PersistentNode* current() const {
+        return path.empty() ? nullptr : path.back();
+    }
+
+    std::vector<const PersistentNode*> path;
+};
+
+// A sorted set with value semantics, where copying is O(1) and every version is immutable
+// insert and erase return a new tree sharing all but O(log n) nodes with this one,
+// so a copy is a snapshot that later versions can't change.
+// Nodes are reference counted, so versions can be handed to other threads and read there,
+// and each node goes with the last version using it.
+template<typename T>
+class PersistentTree {
+public:
+    using Node = PersistentNode<T, SharedNodes>;
+    using iterator = typename Node::Iterator;
+    using const_iterator = iterator;
+
+    PersistentTree() : tree(Node::Link::None()) {}
+
+    PersistentTree insert(T data) const {
+        Writer writer;
+        return PersistentTree(Node::Link::Some(Node::insert(writer, tree, std::move(data))));
+    }
+
+    // The same tree if t is not in it
+    PersistentTree erase(const T& t) const {
+        Writer writer;
+        bool erased = false;
+        return PersistentTree(Node::erase(writer, tree, t, erased));
+    }
+
+    bool contains(const T& t) const {
+        return Node::contains(tree, t);
+    }
+
+    // Calls f on each value in order
+    template<typename F>
+    void apply(F f) const {
+        for(const T& t : *this) {
+            f(t);
+        }
+    }
+
+    iterator begin() const {
+        return iterator(tree);
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    bool empty() const {
+        return !tree.has_value();
+    }
+
+    // Number of levels, 0 when empty
+    int height() const {
+        return Node::height(tree);
+    }
+
+    // Whether the two are the same version, or one is a copy of the other
+    bool same(const PersistentTree& other) const {
+        return Node::get(tree) == Node::get(other.tree);
+    }
+
+private:
+    // Old versions keep what they use alive, so nothing needs retiring
+    struct Writer {
+        template<typename... Args>
+        typename Node::NodeType make(Args&&... args) {
+            return alloc.make(std::forward<Args>(args)...);
+        }
+
+        void retire(const typename Node::NodeType&) {}
+
+        typename Node::Allocator alloc;
+    };
+
+    explicit PersistentTree(typename Node::Link tree) : tree(std::move(tree)) {}
+
+    typename Node::Link tree;
+};
+
+#endif
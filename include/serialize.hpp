@@ -0,0 +1,410 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/serialize.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_SERIALIZE_HPP
+#define ENUM_SERIALIZE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "enum.hpp"
+#include "optional.hpp"
+
+namespace venum {
+
+// Binary encoding
+// An enum is written as its tag, in the smallest unsigned type that fits the number of variants,
+// followed by the object. Values are in the machine's byte order, with no padding,
+// so the encoding is for IPC and files read back on the same kind of machine.
+
+using Bytes = std::vector<unsigned char>;
+
+// Reads from a span of bytes, refusing to read past the end
+class ByteReader {
+public:
+    ByteReader(const void* data, std::size_t size)
+        : next(static_cast<const unsigned char*>(data)), end(next + size) {}
+
+    explicit ByteReader(const Bytes& bytes) : ByteReader(bytes.data(), bytes.size()) {}
+
+    // Copies out the next n bytes, or returns false leaving the reader where it was
+    bool read(void* out, std::size_t n) {
+        if(remaining() < n) {
+            return false;
+        }
+
+        std::memcpy(out, next, n);
+        next += n;
+        return true;
+    }
+
+    // Steps over the next n bytes, returning where they start, or nullptr if there aren't enough
+    const unsigned char* skip(std::size_t n) {
+        if(remaining() < n) {
+            return nullptr;
+        }
+
+        const unsigned char* start = next;
+        next += n;
+        return start;
+    }
+
+    const unsigned char* position() const noexcept {
+        return next;
+    }
+
+    std::size_t remaining() const noexcept {
+        return static_cast<std::size_t>(end - next);
+    }
+
+    bool done() const noexcept {
+        return next == end;
+    }
+
+private:
+    const unsigned char* next;
+    const unsigned char* end;
+};
+
+// Types written as their raw bytes: trivially copyable types other than bool and enums, which
+// have byte patterns that aren't valid values, and pointers, which mean nothing once read back.
+// A struct is copied as a whole, so one with members like those should specialise Serialize.
+template<typename T>
+struct RawBytes : public std::integral_constant<bool,
+    std::is_trivially_copyable<T>::value && !std::is_same<T, bool>::value && !std::is_enum<T>::value
+    && !std::is_pointer<T>::value && !std::is_member_pointer<T>::value> {};
+
+// How an object is written and read back
+// Raw bytes types are copied as they are, and a bool is checked to be 0 or 1. Enums need a
+// specialisation that checks the value is in range. Specialise this for other types, with
+//   static void write(const T& t, Bytes& out)
+//   static Optional<T> read(ByteReader& in)      returning None for bad or missing input
+// and optionally
+//   static bool skip(ByteReader& in)             stepping over one without building it
+template<typename T, typename = void>
+struct Serialize;
+
+template<typename T, typename = void>
+struct HasSkip : public std::false_type {};
+
+template<typename T>
+struct HasSkip<T, decltype(Serialize<T>::skip(std::declval<ByteReader&>()), void())> : public std::true_type {};
+
+template<typename T>
+struct Serialize<T, typename std::enable_if<RawBytes<T>::value>::type> {
+    static void write(const T& t, Bytes& out) {
+        std::size_t size = out.size();
+        out.resize(size + sizeof(T));
+        std::memcpy(out.data() + size, &t, sizeof(T));
+    }
+
+    static Optional<T> read(ByteReader& in) {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type raw;
+
+        if(!in.read(&raw, sizeof(T))) {
+            return Optional<T>::None();
+        }
+
+        return Optional<T>::Some(*reinterpret_cast<const T*>(&raw));
+    }
+
+    static bool skip(ByteReader& in) {
+        return in.skip(sizeof(T)) != nullptr;
+    }
+};
+
+template<>
+struct Serialize<bool> {
+    static void write(bool b, Bytes& out) {
+        out.push_back(b ? 1 : 0);
+    }
+
+    static Optional<bool> read(ByteReader& in) {
+        const unsigned char* byte = in.skip(1);
+
+        if(!byte || *byte > 1) {
+            return Optional<bool>::None();
+        }
+
+        return Optional<bool>::Some(*byte == 1);
+    }
+
+    static bool skip(ByteReader& in) {
+        return in.skip(1) != nullptr;
+    }
+};
+
+template<typename T>
+struct Serialize<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+    static_assert(!std::is_enum<T>::value, "Specialise Serialize for the enum, checking the value read is in range");
+};
+
+// Strings are their length as 32 bits, then their characters
+template<>
+struct Serialize<std::string> {
+    static void write(const std::string& s, Bytes& out) {
+        Serialize<std::uint32_t>::write(static_cast<std::uint32_t>(s.size()), out);
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    static Optional<std::string> read(ByteReader& in) {
+        auto size = Serialize<std::uint32_t>::read(in);
+        const unsigned char* chars = size.has_value() ? in.skip(*size) : nullptr;
+
+        if(!chars) {
+            return Optional<std::string>::None();
+        }
+
+        return Optional<std::string>::Some(std::string(reinterpret_cast<const char*>(chars), *size));
+    }
+
+    static bool skip(ByteReader& in) {
+        auto size = Serialize<std::uint32_t>::read(in);
+        return size.has_value() && in.skip(*size) != nullptr;
+    }
+};
+
+// Encoding and decoding for one enum type
+template<typename E>
+struct Codec;
+
+template<typename Policy, typename... Ts>
+struct Codec<BasicEnumT<Policy, Ts...>> {
+    using Enum = BasicEnumT<Policy, Ts...>;
+    using Variants = TypeList<Ts...>;
+    using Tag = SmallestTag<sizeof...(Ts)>;
+
+    static constexpr std::size_t variants = sizeof...(Ts);
+
+    // Appends e, which must be valid, to out
+    static void encode(const Enum& e, Bytes& out) {
+        e.apply([&out](const auto& t) {
+            using T = typename std::decay<decltype(t)>::type;
+
+            Serialize<Tag>::write(static_cast<Tag>(IndexOf<T, Ts...>::value), out);
+            Serialize<T>::write(t, out);
+        });
+    }
+
+    // Reads the next enum, or returns None if the input is cut short or not an encoded enum,
+    // leaving the reader where it was
+    static Optional<Enum> decode(ByteReader& in) {
+        ByteReader start = in;
+        auto result = decode(in, std::index_sequence_for<Ts...>());
+
+        if(!result.has_value()) {
+            in = start;
+        }
+
+        return result;
+    }
+
+    // Steps over the next enum, without building it where its variant can be skipped,
+    // or returns false as decode would, leaving the reader where it was
+    static bool skip(ByteReader& in) {
+        ByteReader start = in;
+
+        if(!skip_record(in)) {
+            in = start;
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    static bool skip_record(ByteReader& in) {
+        using Fn = bool (*)(ByteReader&);
+        static constexpr Fn table[] = { &skip_nth<Ts>... };
+
+        auto tag = Serialize<Tag>::read(in);
+        return tag.has_value() && *tag < variants && table[*tag](in);
+    }
+
+    template<typename T>
+    static bool skip_nth(ByteReader& in) {
+        return skip_nth<T>(in, HasSkip<T>());
+    }
+
+    template<typename T>
+    static bool skip_nth(ByteReader& in, std::true_type) {
+        return Serialize<T>::skip(in);
+    }
+
+    template<typename T>
+    static bool skip_nth(ByteReader& in, std::false_type) {
+        return Serialize<T>::read(in).has_value();
+    }
+
+    template<std::size_t... ns>
+    static Optional<Enum> decode(ByteReader& in, std::index_sequence<ns...>) {
+        using Fn = Optional<Enum> (*)(ByteReader&);
+        static constexpr Fn table[] = { &decode_nth<ns>... };
+
+        auto tag = Serialize<Tag>::read(in);
+
+        if(!tag.has_value() || *tag >= variants) {
+            return Optional<Enum>::None();
+        }
+
+        return table[*tag](in);
+    }
+
+    template<std::size_t n>
+    static Optional<Enum> decode_nth(ByteReader& in) {
+        using T = typename Variants::template Nth<n>;
+
+        auto t = Serialize<T>::read(in);
+
+        if(!t.has_value()) {
+            return Optional<Enum>::None();
+        }
+
+        // The enum is built in the result, so only the decoded variant is moved
+        return Optional<Enum>(InPlace<Enum>(), InPlaceIndex<n>(), std::move(*t));
+    }
+};
+
+template<typename E>
+void encode(const E& e, Bytes& out) {
+    Codec<E>::encode(e, out);
+}
+
+template<typename E>
+Optional<E> decode(ByteReader& in) {
+    return Codec<E>::decode(in);
+}
+
+// An encoded enum read where it lies, for enums whose variants are all raw bytes (see RawBytes)
+// Nothing is decoded up front: match and apply load the object straight from the buffer
+// (which needn't be aligned) as they call the handler, and the buffer must outlive the view.
+template<typename E>
+class EnumView;
+
+template<typename Policy, typename... Ts>
+class EnumView<BasicEnumT<Policy, Ts...>> {
+public:
+    using Enum = BasicEnumT<Policy, Ts...>;
+    using Tag = typename Codec<Enum>::Tag;
+
+    static_assert(And<RawBytes<Ts>...>::value, "EnumView needs variants that are raw bytes");
+
+    // Steps over the next encoded enum, or returns None if the input is cut short or not an encoded enum,
+    // leaving the reader where it was
+    static Optional<EnumView> read(ByteReader& in) {
+        ByteReader start = in;
+        auto tag = Serialize<Tag>::read(in);
+
+        if(!tag.has_value() || *tag >= sizeof...(Ts) || !in.skip(sizes[*tag])) {
+            in = start;
+            return Optional<EnumView>::None();
+        }
+
+        return Optional<EnumView>::Some(EnumView(start.position(), *tag));
+    }
+
+    std::size_t which() const noexcept {
+        return tag;
+    }
+
+    template<typename T>
+    bool contains() const noexcept {
+        return tag == IndexOf<T, Ts...>::value;
+    }
+
+    // Size of the encoding in bytes
+    std::size_t size() const noexcept {
+        return sizeof(Tag) + sizes[tag];
+    }
+
+    template<typename F>
+    auto apply(F&& f) const {
+        return match(((void)sizeof(Ts), f)...);
+    }
+
+    // Calls the handler for the variant with the object, in order as with Enum::match
+    template<typename... Fs>
+    auto match(Fs&&... fs) const {
+        static_assert(sizeof...(Fs) == sizeof...(Ts), "EnumView::match needs a handler for each variant");
+        return match(std::index_sequence_for<Ts...>(), std::forward_as_tuple(std::forward<Fs>(fs)...));
+    }
+
+    // Decodes into an enum
+    Enum get() const {
+        return get(std::index_sequence_for<Ts...>());
+    }
+
+private:
+    static constexpr std::size_t sizes[] = { sizeof(Ts)... };
+
+    EnumView(const unsigned char* start, Tag tag) : start(start), tag(tag) {}
+
+    template<std::size_t... ns, typename Hs>
+    auto match(std::index_sequence<ns...>, Hs hs) const {
+        using Result = decltype(std::get<0>(hs)(std::declval<const typename TypeList<Ts...>::template Nth<0>&>()));
+        using Fn = Result (*)(const unsigned char*, Hs&);
+        static constexpr Fn table[] = { &call_nth<ns, Result, Hs>... };
+
+        return table[tag](start + sizeof(Tag), hs);
+    }
+
+    template<std::size_t n, typename Result, typename Hs>
+    static Result call_nth(const unsigned char* payload, Hs& hs) {
+        using T = typename TypeList<Ts...>::template Nth<n>;
+
+        // Copying into a local is how to read an unaligned object, and compiles to plain loads
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type raw;
+        std::memcpy(&raw, payload, sizeof(T));
+
+        return std::get<n>(hs)(*reinterpret_cast<const T*>(&raw));
+    }
+
+    template<std::size_t... ns>
+    Enum get(std::index_sequence<ns...>) const {
+        using Fn = Enum (*)(const unsigned char*);
+        static constexpr Fn table[] = { &get_nth<ns>... };
+
+        return table[tag](start + sizeof(Tag));
+    }
+
+    template<std::size_t n>
+    static Enum get_nth(const unsigned char* payload) {
+        using T = typename TypeList<Ts...>::template Nth<n>;
+
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type raw;
+        std::memcpy(&raw, payload, sizeof(T));
+
+        return Enum(InPlaceIndex<n>(), *reinterpret_cast<const T*>(&raw));
+    }
+
+    const unsigned char* start;
+    Tag tag;
+};
+
+template<typename Policy, typename... Ts>
+constexpr std::size_t EnumView<BasicEnumT<Policy, Ts...>>::sizes[];
+
+}
+
+#endif
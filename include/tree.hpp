@@ -19,95 +19,1046 @@
 #ifndef ENUM_TREE_HPP
 #define ENUM_TREE_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "enum.hpp"
+#include "optional.hpp"
 
-template<typename T>
+// Parallel
+// Runs task(i) for every i below count, on up to threads threads including this one
+// Each thread claims the next index when it finishes one, so a thread that
+// draws small tasks goes on to take work the others haven't reached
+// If a task throws, the rest are skipped and the first exception is rethrown here
+template<typename Task>
+void parallel_for(std::size_t count, unsigned threads, Task&& task) {
+    if(threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+
+    std::atomic<std::size_t> claimed(0);
+    std::exception_ptr error;
+    std::atomic<bool> failed(false);
+
+    auto worker = [&]() {
+        std::size_t i;
+        while(!failed.load(std::memory_order_relaxed) && (i = claimed.fetch_add(1, std::memory_order_relaxed)) < count) {
+        #if VENUM_EXCEPTIONS
+            try {
+                task(i);
+            } catch(...) {
+                if(!failed.exchange(true)) {
+                    error = std::current_exception();
+                }
+            }
+        #else
+            task(i);
+        #endif
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+
+    worker();
+
+    for(auto& thread : pool) {
+        thread.join();
+    }
+
+#if VENUM_EXCEPTIONS
+    if(error) {
+        std::rethrow_exception(error);
+    }
+#endif
+}
+
+// Sorts a random access range, sorting a slice per thread and then merging pairs of slices in parallel
+template<typename It>
+void parallel_sort(It first, It last, unsigned threads = 0) {
+    if(threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::size_t n = static_cast<std::size_t>(last - first);
+    std::size_t slices = std::max<std::size_t>(1, std::min<std::size_t>(threads, n / 4096));
+    std::size_t width = (n + slices - 1) / std::max<std::size_t>(1, slices);
+
+    auto bound = [&](std::size_t i) {
+        return first + static_cast<std::ptrdiff_t>(std::min(i * width, n));
+    };
+
+    parallel_for(slices, threads, [&](std::size_t i) {
+        std::sort(bound(i), bound(i + 1));
+    });
+
+    for(std::size_t step = 1; step < slices; step *= 2) {
+        parallel_for((slices + 2 * step - 1) / (2 * step), threads, [&](std::size_t i) {
+            std::size_t lhs = 2 * step * i;
+            std::inplace_merge(bound(lhs), bound(lhs + step), bound(lhs + 2 * step));
+        });
+    }
+}
+
+// Balancing
+// Rebalances the subtree at a link after an insert or erase below it
+// Unbalanced is the plain BST, which degrades to a list on sorted input
+struct Unbalanced {
+    template<typename Node>
+    static void rebalance(typename Node::Link& link) {
+        (*link)->update();
+    }
+};
+
+// AVL keeps the heights of every node's subtrees within one of each other,
+// so the tree stays O(log n) deep whatever order keys arrive in
+struct AVL {
+    template<typename Node>
+    static void rebalance(typename Node::Link& link) {
+        auto& node = *link;
+        int balance = Node::height(node->lhs) - Node::height(node->rhs);
+
+        if(balance > 1) {
+            if(Node::height((*node->lhs)->lhs) < Node::height((*node->lhs)->rhs)) {
+                Node::rotate_left(node->lhs);
+            }
+
+            Node::rotate_right(link);
+        } else if(balance < -1) {
+            if(Node::height((*node->rhs)->rhs) < Node::height((*node->rhs)->lhs)) {
+                Node::rotate_right(node->rhs);
+            }
+
+            Node::rotate_left(link);
+        } else {
+            node->update();
+        }
+    }
+};
+
+// Node storage
+// Decides what a link points at and where nodes come from
+// SharedNodes allocates each node with make_shared, and a node is freed when the last link to it goes
+// Clearing takes the nodes apart one at a time, so freeing a long chain doesn't recurse
+struct SharedNodes {
+    template<typename Node>
+    using Pointer = std::shared_ptr<Node>;
+
+    template<typename Node>
+    class Allocator {
+    public:
+        template<typename... Args>
+        Pointer<Node> make(Args&&... args) {
+            return std::make_shared<Node>(std::forward<Args>(args)...);
+        }
+
+        // The node goes when its last link does
+        void destroy(const Pointer<Node>&) {}
+
+        template<typename Link>
+        void clear(Link& root) {
+            Node::unlink_all(root);
+        }
+    };
+};
+
+// ArenaNodes allocates nodes from contiguous slabs and links them with raw pointers
+// Erased nodes are reused, and clearing the tree frees the slabs without
+// visiting the nodes if they are trivially destructible
+struct ArenaNodes {
+    template<typename Node>
+    using Pointer = Node*;
+
+    template<typename Node>
+    class Allocator {
+    public:
+        static constexpr std::size_t slab_size = 4096;
+
+        Allocator() = default;
+
+        Allocator(Allocator&& other) noexcept 
+            : slabs(std::move(other.slabs)), next(other.next), end(other.end), free(other.free) {
+
+            other.reset();
+        }
+
+        Allocator& operator=(Allocator&& other) noexcept {
+            slabs = std::move(other.slabs);
+            next = other.next;
+            end = other.end;
+            free = other.free;
+
+            other.reset();
+            return *this;
+        }
+
+        template<typename... Args>
+        Node* make(Args&&... args) {
+            return ::new (allocate()) Node(std::forward<Args>(args)...);
+        }
+
+        void destroy(Node* node) {
+            node->~Node();
+
+            Slot* slot = reinterpret_cast<Slot*>(node);
+            slot->next = free;
+            free = slot;
+        }
+
+        template<typename Link>
+        void clear(Link& root) {
+            if(!std::is_trivially_destructible<Node>::value) {
+                Node::destroy_all(root);
+            }
+
+            slabs.clear();
+            reset();
+            root = Link::None();
+        }
+
+    private:
+        union Slot {
+            Slot* next;
+            typename std::aligned_storage<sizeof(Node), alignof(Node)>::type storage;
+        };
+
+        void* allocate() {
+            if(free) {
+                Slot* slot = free;
+                free = slot->next;
+                return slot;
+            }
+
+            if(next == end) {
+                slabs.emplace_back(new Slot[slab_size]);
+                next = slabs.back().get();
+                end = next + slab_size;
+            }
+
+            return next++;
+        }
+
+        void reset() {
+            next = end = free = nullptr;
+        }
+
+        std::vector<std::unique_ptr<Slot[]>> slabs;
+        Slot* next = nullptr;
+        Slot* end = nullptr;
+        Slot* free = nullptr;
+    };
+};
+
+// Nodes are reached through links, which are Optionals of node pointers
+// Each node also has a plain pointer to its parent, so the operations below
+// can walk the tree with loops rather than recursion
+template<typename T, typename Balance, typename Storage>
 class TreeNode {
 public:
-    using NodeType = std::shared_ptr<TreeNode<T>>;
+    using NodeType = typename Storage::template Pointer<TreeNode<T, Balance, Storage>>;
+    using Link = Optional<NodeType>;
+    using Allocator = typename Storage::template Allocator<TreeNode<T, Balance, Storage>>;
+
+    class Iterator;
 
     TreeNode() = delete;
 
-    TreeNode(T data) : data(data), lhs(Optional<NodeType>::None()), rhs(Optional<NodeType>::None()) {}
+    TreeNode(T data, TreeNode* parent) : data(std::move(data)), parent(parent), lhs(Link::None()), rhs(Link::None()) {}
 
-    void insert(T data) {
-        if(data < this->data) {
-            lhs.match(
-                [this, data](None) { lhs = Optional<NodeType>::Some(std::make_shared<TreeNode<T>>(data)); },
-                [data](NodeType node) { node->insert(data); }
-            );
-        } else {
-            rhs.match(
-                [this, data](None) { rhs = Optional<NodeType>::Some(std::make_shared<TreeNode<T>>(data)); },
-                [data](NodeType node) { node->insert(data); }
-            );
+    static void insert(Link& root, T data, Allocator& alloc) {
+        Link* link = &root;
+        TreeNode* parent = nullptr;
+
+        while(link->has_value()) {
+            parent = get(*link);
+            link = &(data < parent->data ? parent->lhs : parent->rhs);
+        }
+
+        *link = Link::Some(alloc.make(std::move(data), parent));
+        rebalance_from(root, parent);
+    }
+
+    // Returns false if t was not in the tree
+    static bool erase(Link& root, const T& t, Allocator& alloc) {
+        TreeNode* node = find(root, t);
+
+        if(!node) {
+            return false;
+        }
+
+        // With two children, take the next node's data and remove that node instead
+        if(node->lhs.has_value() && node->rhs.has_value()) {
+            TreeNode* next = leftmost(get(node->rhs));
+            node->data = std::move(next->data);
+            node = next;
+        }
+
+        // The node now has at most one child, which takes its place
+        TreeNode* parent = node->parent;
+        Link& child = node->lhs.has_value() ? node->lhs : node->rhs;
+
+        if(child.has_value()) {
+            get(child)->parent = parent;
+        }
+
+        NodeType removed = *link_to(root, node);
+        Link replacement = std::move(child);
+        link_to(root, node) = std::move(replacement);
+        alloc.destroy(removed);
+
+        rebalance_from(root, parent);
+        return true;
+    }
+
+    // Returns the node holding t, or nullptr
+    static TreeNode* find(const Link& root, const T& t) {
+        // Stepping from link to link, rather than node to node, compiles to a
+        // conditional move where the other form mispredicts a branch every other level
+        const Link* link = &root;
+
+        while(link->has_value()) {
+            TreeNode* node = get(*link);
+
+            if(t == node->data) {
+                return node;
+            }
+
+            link = t < node->data ? &node->lhs : &node->rhs;
+        }
+
+        return nullptr;
+    }
+
+    // First node not less than t, or nullptr
+    static TreeNode* lower_bound(const Link& root, const T& t) {
+        const Link* link = &root;
+        TreeNode* result = nullptr;
+
+        while(link->has_value()) {
+            TreeNode* node = get(*link);
+
+            if(node->data < t) {
+                link = &node->rhs;
+            } else {
+                result = node;
+                link = &node->lhs;
+            }
+        }
+
+        return result;
+    }
+
+    // First node greater than t, or nullptr
+    static TreeNode* upper_bound(const Link& root, const T& t) {
+        const Link* link = &root;
+        TreeNode* result = nullptr;
+
+        while(link->has_value()) {
+            TreeNode* node = get(*link);
+
+            if(t < node->data) {
+                result = node;
+                link = &node->lhs;
+            } else {
+                link = &node->rhs;
+            }
         }
+
+        return result;
     }
 
+    static TreeNode* leftmost(TreeNode* node) {
+        while(node && node->lhs.has_value()) {
+            node = get(node->lhs);
+        }
+
+        return node;
+    }
+
+    static TreeNode* rightmost(TreeNode* node) {
+        while(node && node->rhs.has_value()) {
+            node = get(node->rhs);
+        }
+
+        return node;
+    }
+
+    // In-order neighbours, nullptr past either end
+    static const TreeNode* next(const TreeNode* node) {
+        if(node->rhs.has_value()) {
+            return leftmost(get(node->rhs));
+        }
+
+        while(node->parent && get(node->parent->rhs) == node) {
+            node = node->parent;
+        }
+
+        return node->parent;
+    }
+
+    static const TreeNode* prev(const TreeNode* node) {
+        if(node->lhs.has_value()) {
+            return rightmost(get(node->lhs));
+        }
+
+        while(node->parent && get(node->parent->lhs) == node) {
+            node = node->parent;
+        }
+
+        return node->parent;
+    }
+
+    // Builds a perfectly balanced subtree at link from the next count values of it,
+    // which must be sorted, returning its height
+    // Each value is read once, in order, and the recursion is only O(log n) deep
+    template<typename It>
+    static int build(Link& link, TreeNode* parent, It& it, std::size_t count, Allocator& alloc) {
+        if(count == 0) {
+            return 0;
+        }
+
+        // The left subtree comes first in the input, but needs its parent fixing after
+        std::size_t left = count / 2;
+        Link lhs = Link::None();
+        int lhs_height = build(lhs, nullptr, it, left, alloc);
+
+        link = Link::Some(alloc.make(*it, parent));
+        ++it;
+
+        TreeNode* node = get(link);
+        node->lhs = std::move(lhs);
+        if(node->lhs.has_value()) {
+            get(node->lhs)->parent = node;
+        }
+
+        int rhs_height = build(node->rhs, node, it, count - left - 1, alloc);
+
+        node->h = 1 + std::max(lhs_height, rhs_height);
+        return node->h;
+    }
+
+    // A piece of the tree for a parallel pass: a node alone, or the whole subtree under it
+    struct Piece {
+        TreeNode* node;
+        bool subtree;
+    };
+
+    // Splits the subtree at node into pieces, in order, with every subtree at the given depth as one piece
+    static void split(TreeNode* node, int depth, std::vector<Piece>& pieces) {
+        if(!node) {
+            return;
+        }
+
+        if(depth == 0) {
+            pieces.push_back({ node, true });
+            return;
+        }
+
+        split(get(node->lhs), depth - 1, pieces);
+        pieces.push_back({ node, false });
+        split(get(node->rhs), depth - 1, pieces);
+    }
+
+    // Calls f on each value of a piece in order
     template<typename F>
-    void apply(F f) {
-        lhs.match(
-            [](None) {},
-            [&f](NodeType node) { node->apply(f); }
-        );
+    static void visit(const Piece& piece, F&& f) {
+        if(!piece.subtree) {
+            f(piece.node->data);
+            return;
+        }
 
-        f(data);
+        const TreeNode* last = rightmost(piece.node);
+        for(const TreeNode* node = leftmost(piece.node); ; node = next(node)) {
+            f(node->data);
 
-        rhs.match(
-            [](None) {},
-            [&f](NodeType node) { node->apply(f); }
-        );
+            if(node == last) {
+                break;
+            }
+        }
     }
 
-    bool contains(const T& t) {
-        if(t == data) {
-            return true;
-        } else {
-            return (t < data ? lhs : rhs).match(
-                [](None) { return false; },
-                [t](NodeType node) { return node->contains(t); }
-            );
+    // Copies the nodes below from to to, keeping the shape, without recursing
+    static void copy_all(const Link& from, Link& to, Allocator& alloc) {
+        struct Pending {
+            const TreeNode* node;
+            Link* link;
+            TreeNode* parent;
+        };
+
+        std::vector<Pending> stack;
+
+        if(from.has_value()) {
+            stack.push_back(Pending{ get(from), &to, nullptr });
+        }
+
+        while(!stack.empty()) {
+            Pending pending = stack.back();
+            stack.pop_back();
+
+            *pending.link = Link::Some(alloc.make(pending.node->data, pending.parent));
+
+            TreeNode* copy = get(*pending.link);
+            copy->h = pending.node->h;
+
+            if(pending.node->lhs.has_value()) {
+                stack.push_back(Pending{ get(pending.node->lhs), &copy->lhs, copy });
+            }
+
+            if(pending.node->rhs.has_value()) {
+                stack.push_back(Pending{ get(pending.node->rhs), &copy->rhs, copy });
+            }
+        }
+    }
+
+    // Drops the shared nodes below link, taking each one's children before it goes so
+    // no destructor recurses. A node still linked from elsewhere is left whole.
+    static void unlink_all(Link& link) {
+        std::vector<NodeType> stack;
+
+        if(link.has_value()) {
+            stack.push_back(std::move(*link));
+        }
+
+        link = Link::None();
+
+        while(!stack.empty()) {
+            NodeType node = std::move(stack.back());
+            stack.pop_back();
+
+            if(node.use_count() == 1) {
+                if(node->lhs.has_value()) {
+                    stack.push_back(std::move(*node->lhs));
+                }
+
+                if(node->rhs.has_value()) {
+                    stack.push_back(std::move(*node->rhs));
+                }
+            }
+        }
+    }
+
+    // Runs the destructor of every node below link, without recursing
+    static void destroy_all(Link& link) {
+        std::vector<NodeType> stack;
+
+        if(link.has_value()) {
+            stack.push_back(*link);
+        }
+
+        while(!stack.empty()) {
+            NodeType node = stack.back();
+            stack.pop_back();
+
+            if(node->lhs.has_value()) {
+                stack.push_back(*node->lhs);
+            }
+
+            if(node->rhs.has_value()) {
+                stack.push_back(*node->rhs);
+            }
+
+            node->~TreeNode();
+        }
+    }
+
+    static TreeNode* get(const Link& link) {
+        return link.has_value() ? &**link : nullptr;
+    }
+
+    static int height(const Link& link) {
+        return link.has_value() ? (*link)->h : 0;
+    }
+
+    void update() {
+        h = 1 + std::max(height(lhs), height(rhs));
+    }
+
+    // Rotations for the balancing policy, which keep the parent pointers right
+    static void rotate_right(Link& link) {
+        NodeType node = *link;
+        NodeType pivot = *node->lhs;
+
+        node->lhs = std::move(pivot->rhs);
+        if(node->lhs.has_value()) {
+            get(node->lhs)->parent = &*node;
+        }
+
+        pivot->parent = node->parent;
+        node->parent = &*pivot;
+        node->update();
+
+        pivot->rhs = Link::Some(std::move(node));
+        pivot->update();
+
+        link = Link::Some(std::move(pivot));
+    }
+
+    static void rotate_left(Link& link) {
+        NodeType node = *link;
+        NodeType pivot = *node->rhs;
+
+        node->rhs = std::move(pivot->lhs);
+        if(node->rhs.has_value()) {
+            get(node->rhs)->parent = &*node;
         }
+
+        pivot->parent = node->parent;
+        node->parent = &*pivot;
+        node->update();
+
+        pivot->lhs = Link::Some(std::move(node));
+        pivot->update();
+
+        link = Link::Some(std::move(pivot));
     }
 
 private:
+    friend Balance;
+
+    // The link that points at node
+    static Link& link_to(Link& root, TreeNode* node) {
+        if(!node->parent) {
+            return root;
+        }
+
+        return get(node->parent->lhs) == node ? node->parent->lhs : node->parent->rhs;
+    }
+
+    // Rebalances each subtree from node up to the root, stopping once one keeps its height,
+    // as nothing above it can have changed
+    static void rebalance_from(Link& root, TreeNode* node) {
+        while(node) {
+            TreeNode* up = node->parent;
+            int before = node->h;
+
+            Link& link = link_to(root, node);
+            Balance::template rebalance<TreeNode>(link);
+
+            if(height(link) == before) {
+                break;
+            }
+
+            node = up;
+        }
+    }
+
     T data;
-    Optional<NodeType> lhs, rhs;
+    int h = 1;
+    TreeNode* parent;
+    Link lhs, rhs;
+};
+
+// Bidirectional in-order iterator, over const values as changing one could break the ordering
+template<typename T, typename Balance, typename Storage>
+class TreeNode<T, Balance, Storage>::Iterator {
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    Iterator() = default;
+
+    Iterator(const TreeNode* node, const Link* root) : node(node), root(root) {}
+
+    reference operator*() const {
+        return node->data;
+    }
+
+    pointer operator->() const {
+        return &node->data;
+    }
+
+    Iterator& operator++() {
+        node = next(node);
+        return *this;
+    }
+
+    Iterator operator++(int) {
+        Iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    // Decrementing end() gives the last node
+    Iterator& operator--() {
+        node = node ? prev(node) : rightmost(get(*root));
+        return *this;
+    }
+
+    Iterator operator--(int) {
+        Iterator copy = *this;
+        --*this;
+        return copy;
+    }
+
+    bool operator==(const Iterator& other) const {
+        return node == other.node;
+    }
+
+    bool operator!=(const Iterator& other) const {
+        return node != other.node;
+    }
+
+private:
+    const TreeNode* node = nullptr;
+    const Link* root = nullptr;
+};
+
+// Frozen
+// An immutable sorted set in Eytzinger order: an implicit binary tree in one array, with
+// the root at 1 and the children of k at 2k and 2k + 1. A search reads the array front
+// to back with no pointers to chase, and can prefetch the levels below it.
+template<typename T>
+class FrozenTree {
+public:
+    class Iterator;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    FrozenTree() = default;
+
+    // From a sorted range
+    template<typename It>
+    FrozenTree(It first, It last) {
+        std::vector<T> sorted(first, last);
+        std::size_t n = sorted.size();
+
+        // Walk the positions in order to find which sorted value goes where
+        std::vector<std::size_t> rank(n + 1);
+        std::size_t r = 0;
+        for(std::size_t k = leftmost(1, n); k != 0; k = next(k, n)) {
+            rank[k] = r++;
+        }
+
+        keys.reserve(n);
+        for(std::size_t k = 1; k <= n; ++k) {
+            keys.push_back(std::move(sorted[rank[k]]));
+        }
+    }
+
+    // First value not less than t
+    // The loop has no data dependent branches, and reads ahead a cache line of descendants
+    iterator lower_bound(const T& t) const {
+        const std::size_t n = keys.size();
+        std::size_t k = 1;
+
+        while(k <= n) {
+            prefetch(std::min(k * per_line, n));
+            k = 2 * k + (keys[k - 1] < t);
+        }
+
+        // Each right step after the last left one went past the answer, so undo them and that left step
+        k >>= trailing_ones(k) + 1;
+        return iterator(this, k);
+    }
+
+    bool contains(const T& t) const {
+        auto it = lower_bound(t);
+        return it != end() && !(t < *it);
+    }
+
+    iterator begin() const {
+        return iterator(this, leftmost(1, keys.size()));
+    }
+
+    iterator end() const {
+        return iterator(this, 0);
+    }
+
+    std::size_t size() const noexcept {
+        return keys.size();
+    }
+
+    bool empty() const noexcept {
+        return keys.empty();
+    }
+
+private:
+    // How many values fit in a cache line, which is also how far ahead
+    // in the array the subtree four or so levels down starts
+    static constexpr std::size_t per_line = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+
+    void prefetch(std::size_t k) const {
+#if defined(__GNUC__)
+        __builtin_prefetch(&keys[k - 1]);
+#else
+        (void)k;
+#endif
+    }
+
+    static std::size_t trailing_ones(std::size_t k) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(~static_cast<unsigned long long>(k));
+#else
+        std::size_t count = 0;
+        for(; k & 1; k >>= 1) {
+            ++count;
+        }
+        return count;
+#endif
+    }
+
+    // The first position in order of the subtree at k, or 0 if it is empty
+    static std::size_t leftmost(std::size_t k, std::size_t n) {
+        if(k > n) {
+            return 0;
+        }
+
+        while(2 * k <= n) {
+            k = 2 * k;
+        }
+
+        return k;
+    }
+
+    // The next position in order, or 0 past the end
+    static std::size_t next(std::size_t k, std::size_t n) {
+        if(2 * k + 1 <= n) {
+            return leftmost(2 * k + 1, n);
+        }
+
+        // Climb out of right subtrees, then up once more
+        return k >> (trailing_ones(k) + 1);
+    }
+
+    std::vector<T> keys;
 };
 
+// Forward in-order iterator over a frozen tree
 template<typename T>
+class FrozenTree<T>::Iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    Iterator() = default;
+
+    Iterator(const FrozenTree* tree, std::size_t k) : tree(tree), k(k) {}
+
+    reference operator*() const {
+        return tree->keys[k - 1];
+    }
+
+    pointer operator->() const {
+        return &tree->keys[k - 1];
+    }
+
+    Iterator& operator++() {
+        k = next(k, tree->keys.size());
+        return *this;
+    }
+
+    Iterator operator++(int) {
+        Iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    bool operator==(const Iterator& other) const {
+        return k == other.k;
+    }
+
+    bool operator!=(const Iterator& other) const {
+        return k != other.k;
+    }
+
+private:
+    const FrozenTree* tree = nullptr;
+    std::size_t k = 0;
+};
+
+template<typename T, typename Balance = AVL, typename Storage = ArenaNodes>
 class Tree {
 public:
-    using NodeType = std::shared_ptr<TreeNode<T>>;
+    using Node = TreeNode<T, Balance, Storage>;
+    using NodeType = typename Node::NodeType;
+    using iterator = typename Node::Iterator;
+    using const_iterator = iterator;
 
-    Tree() : tree(Optional<NodeType>::None()) {}
+    Tree() : tree(Node::Link::None()) {}
+
+    // Copies are deep, with the same shape as the original
+    Tree(const Tree& other) : Tree() {
+        Node::copy_all(other.tree, tree, alloc);
+    }
+
+    Tree& operator=(const Tree& other) {
+        if(this != &other) {
+            Tree copy(other);
+            *this = std::move(copy);
+        }
+
+        return *this;
+    }
+
+    Tree(Tree&& other) noexcept : tree(std::move(other.tree)), alloc(std::move(other.alloc)) {
+        other.tree = Node::Link::None();
+    }
+
+    Tree& operator=(Tree&& other) noexcept {
+        if(this != &other) {
+            clear();
+            tree = std::move(other.tree);
+            alloc = std::move(other.alloc);
+            other.tree = Node::Link::None();
+        }
+
+        return *this;
+    }
+
+    ~Tree() {
+        clear();
+    }
 
     void insert(T data) {
-        tree.match(
-            [this, data](None) { tree = Optional<NodeType>::Some(std::make_shared<TreeNode<T>>(data)); },
-            [data](NodeType node) { node->insert(data); }
-        );
+        Node::insert(tree, std::move(data), alloc);
+    }
+
+    bool erase(const T& t) {
+        return Node::erase(tree, t, alloc);
     }
 
+    // Removes everything, which with ArenaNodes frees the slabs in one go
+    void clear() {
+        alloc.clear(tree);
+    }
+
+    // Calls f on each value in order
     template<typename F>
-    void apply(F f) {
-        tree.match(
-            [](None){},
-            [&f](NodeType node) { node->apply(f); }
-        );
+    void apply(F f) const {
+        for(const T& t : *this) {
+            f(t);
+        }
+    }
+
+    // Calls f on each value from several threads at once (0 for one per core),
+    // so f must be safe to call concurrently and the order is unspecified
+    template<typename F>
+    void parallel_apply(F f, unsigned threads = 0) const {
+        auto pieces = split(threads);
+
+        parallel_for(pieces.size(), threads, [&](std::size_t i) {
+            Node::visit(pieces[i], f);
+        });
+    }
+
+    // Folds the values in order, as combine(...combine(combine(init, map(a)), map(b))..., map(z))
+    // Pieces of the tree are mapped and folded in parallel, then the results are combined in order,
+    // so combine must be associative but needn't be commutative
+    template<typename R, typename Map, typename Combine>
+    R parallel_reduce(R init, Map map, Combine combine, unsigned threads = 0) const {
+        auto pieces = split(threads);
+        std::vector<Optional<R>> results(pieces.size(), Optional<R>::None());
+
+        parallel_for(pieces.size(), threads, [&](std::size_t i) {
+            Optional<R> result = Optional<R>::None();
+
+            Node::visit(pieces[i], [&](const T& t) {
+                result = result.has_value()
+                    ? Optional<R>::Some(combine(std::move(*result), map(t)))
+                    : Optional<R>::Some(map(t));
+            });
+
+            results[i] = std::move(result);
+        });
+
+        for(auto& result : results) {
+            if(result.has_value()) {
+                init = combine(std::move(init), std::move(*result));
+            }
+        }
+
+        return init;
+    }
+
+    bool contains(const T& t) const {
+        return Node::find(tree, t) != nullptr;
+    }
+
+    iterator begin() const {
+        return iterator(Node::leftmost(Node::get(tree)), &tree);
+    }
+
+    iterator end() const {
+        return iterator(nullptr, &tree);
+    }
+
+    // Range scans, O(log n) to find the start
+    iterator lower_bound(const T& t) const {
+        return iterator(Node::lower_bound(tree, t), &tree);
+    }
+
+    iterator upper_bound(const T& t) const {
+        return iterator(Node::upper_bound(tree, t), &tree);
+    }
+
+    std::pair<iterator, iterator> equal_range(const T& t) const {
+        return { lower_bound(t), upper_bound(t) };
+    }
+
+    // Builds a perfectly balanced tree from a sorted range in O(n)
+    template<typename It>
+    static Tree build_from_sorted(It first, It last) {
+        Tree result;
+        Node::build(result.tree, nullptr, first, static_cast<std::size_t>(std::distance(first, last)), result.alloc);
+        return result;
     }
 
-    bool contains(const T& t) {
-        return tree.match(
-            [](None) { return false; },
-            [t](NodeType node) { return node->contains(t); }
-        );
+    // Builds a balanced tree from values in any order, sorting a copy of them in parallel first
+    template<typename It>
+    static Tree build_from_unsorted(It first, It last, unsigned threads = 0) {
+        std::vector<T> values(first, last);
+        parallel_sort(values.begin(), values.end(), threads);
+        return build_from_sorted(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+    }
+
+    // An immutable copy for fast lookups
+    FrozenTree<T> freeze() const {
+        return FrozenTree<T>(begin(), end());
+    }
+
+    // Number of levels, 0 when empty
+    int height() const {
+        return Node::height(tree);
     }
 
 private:
-    Optional<NodeType> tree;
+    // Enough pieces for the threads to share the work evenly, even if some subtrees are deeper
+    std::vector<typename Node::Piece> split(unsigned threads) const {
+        if(threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        int depth = 0;
+        while(depth < height() && (std::size_t(1) << depth) < 8 * std::size_t(threads)) {
+            ++depth;
+        }
+
+        std::vector<typename Node::Piece> pieces;
+        Node::split(Node::get(tree), threads == 1 ? 0 : depth, pieces);
+        return pieces;
+    }
+
+    typename Node::Link tree;
+    typename Node::Allocator alloc;
 };
 
 #endif
@@ -0,0 +1,553 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/variant_log.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_VARIANT_LOG_HPP
+#define ENUM_VARIANT_LOG_HPP
+
+#if defined(_WIN32)
+#error "variant_log.hpp needs POSIX mmap"
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "enum.hpp"
+#include "optional.hpp"
+#include "serialize.hpp"
+
+namespace venum {
+
+struct LogOptions {
+    // Open for appending, creating the file if it doesn't exist, rather than read only
+    bool write = true;
+
+    // Keep the offset of every record in <path>.idx, written on flush, so opening
+    // doesn't have to read through the whole log to find them
+    bool offset_index = true;
+
+    // Keep a list of the records of each variant, for for_each_of
+    bool tag_index = false;
+};
+
+// An append-only file of encoded enums (see serialize.hpp), read through a memory mapping
+//
+// The file is a 16 byte header, holding the end of the last complete record, then the records.
+// Reading doesn't copy the log anywhere: records are decoded (or with variants that are
+// raw bytes, see RawBytes, read in place) as they are visited, so only the pages touched are read from disk.
+// One process appends at a time, and readers see what had been flushed when they opened.
+template<typename... Ts>
+class VariantLog {
+public:
+    using Enum = EnumT<Ts...>;
+
+    static constexpr bool flat = And<RawBytes<Ts>...>::value;
+
+    // Returns None if the file can't be opened or mapped, or isn't a log
+    static Optional<VariantLog> open(const std::string& path, LogOptions options = LogOptions()) {
+        VariantLog log(path, options);
+
+        if(!log.load()) {
+            log.release();
+            return Optional<VariantLog>::None();
+        }
+
+        return Optional<VariantLog>::Some(std::move(log));
+    }
+
+    VariantLog(VariantLog&& other) noexcept
+        : path(std::move(other.path)), options(other.options), fd(other.fd), base(other.base),
+          capacity(other.capacity), offsets(std::move(other.offsets)), tags(std::move(other.tags)),
+          indexed(other.indexed), scratch(std::move(other.scratch)) {
+
+        other.fd = -1;
+        other.base = nullptr;
+    }
+
+    VariantLog& operator=(VariantLog&& other) noexcept {
+        if(this != &other) {
+            close();
+
+            path = std::move(other.path);
+            options = other.options;
+            fd = other.fd;
+            base = other.base;
+            capacity = other.capacity;
+            offsets = std::move(other.offsets);
+            tags = std::move(other.tags);
+            indexed = other.indexed;
+            scratch = std::move(other.scratch);
+
+            other.fd = -1;
+            other.base = nullptr;
+        }
+
+        return *this;
+    }
+
+    VariantLog(const VariantLog&) = delete;
+    VariantLog& operator=(const VariantLog&) = delete;
+
+    ~VariantLog() {
+        close();
+    }
+
+    // Adds e to the end of the log, returning false if it is read only or the file couldn't grow
+    bool append(const Enum& e) {
+        if(!options.write) {
+            return false;
+        }
+
+        scratch.clear();
+        encode(e, scratch);
+
+        std::uint64_t offset = end();
+        if(!reserve(offset + scratch.size())) {
+            return false;
+        }
+
+        std::memcpy(base + offset, scratch.data(), scratch.size());
+        header().end = offset + scratch.size();
+
+        add(offset, e.which());
+        return true;
+    }
+
+    // Writes the mapping and offset index out to disk
+    void flush() {
+        if(!options.write || !base) {
+            return;
+        }
+
+        ::msync(base, static_cast<std::size_t>(end()), MS_SYNC);
+
+        if(options.offset_index && indexed != offsets.size()) {
+            write_index();
+        }
+    }
+
+    // Number of records
+    std::size_t size() const noexcept {
+        return offsets.size();
+    }
+
+    bool empty() const noexcept {
+        return offsets.empty();
+    }
+
+    // The ith record, or None if it doesn't decode
+    // Every record starts where the one before ends (see agrees), so that only happens
+    // if the bytes of a record were changed after it was written
+    Optional<Enum> at(std::size_t i) const {
+        ByteReader in = record(i);
+        return decode<Enum>(in);
+    }
+
+    // Calls the matching handler for every record in order, returning false
+    // if it stopped at a record that doesn't decode (see at)
+    // With flat variants (raw bytes), each object is read straight out of the mapping
+    template<typename... Fs>
+    bool for_each(Fs&&... fs) const {
+        for(std::size_t i = 0; i < offsets.size(); ++i) {
+            if(!visit(std::integral_constant<bool, flat>(), record(i), fs...)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Calls f for every record holding a T, in order, returning false as for_each does
+    // With the tag index only those records are read, otherwise each record's tag is checked
+    template<typename T, typename F>
+    bool for_each_of(F&& f) const {
+        constexpr std::size_t n = IndexOf<T, Ts...>::value;
+
+        if(options.tag_index) {
+            for(std::size_t i : tags[n]) {
+                if(!visit_payload<T>(i, f)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        for(std::size_t i = 0; i < offsets.size(); ++i) {
+            if(tag_at(i) == n && !visit_payload<T>(i, f)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Number of records holding a T, which reads every tag without the tag index
+    template<typename T>
+    std::size_t count() const noexcept {
+        constexpr std::size_t n = IndexOf<T, Ts...>::value;
+
+        if(options.tag_index) {
+            return tags[n].size();
+        }
+
+        std::size_t result = 0;
+        for(std::size_t i = 0; i < offsets.size(); ++i) {
+            result += tag_at(i) == n ? 1 : 0;
+        }
+
+        return result;
+    }
+
+private:
+    using Tag = typename Codec<Enum>::Tag;
+
+    static constexpr char magic[8] = { 'V', 'E', 'N', 'U', 'M', 'L', 'O', 'G' };
+    static constexpr std::size_t initial_capacity = 1 << 20;
+    static constexpr std::size_t sizes[] = { sizeof(Ts)... };
+
+    struct Header {
+        char magic[8];
+        std::uint64_t end;
+    };
+
+    VariantLog(std::string path, LogOptions options) : path(std::move(path)), options(options) {}
+
+    // Opens and maps the file, then finds the records from the index and a scan of any after it
+    bool load() {
+        fd = ::open(path.c_str(), options.write ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+
+        struct stat st;
+        if(fd < 0 || ::fstat(fd, &st) != 0) {
+            return false;
+        }
+
+        std::uint64_t size = static_cast<std::uint64_t>(st.st_size);
+
+        if(size == 0) {
+            if(!options.write || !(base = map(initial_capacity))) {
+                return false;
+            }
+
+            capacity = initial_capacity;
+            std::memcpy(header().magic, magic, sizeof(magic));
+            header().end = sizeof(Header);
+        } else {
+            if(size < sizeof(Header) || !(base = map(size))) {
+                return false;
+            }
+
+            capacity = size;
+
+            if(std::memcmp(header().magic, magic, sizeof(magic)) != 0 || header().end > size) {
+                return false;
+            }
+        }
+
+        tags.resize(options.tag_index ? sizeof...(Ts) : 0);
+
+        if(options.offset_index) {
+            read_index();
+        }
+
+        return scan();
+    }
+
+    // Maps the first size bytes of the file, growing it to that size first when writing,
+    // or returns nullptr
+    unsigned char* map(std::uint64_t size) {
+        if(options.write && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            return nullptr;
+        }
+
+        int protection = PROT_READ | (options.write ? PROT_WRITE : 0);
+        void* mapping = ::mmap(nullptr, static_cast<std::size_t>(size), protection, MAP_SHARED, fd, 0);
+
+        return mapping == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapping);
+    }
+
+    // Grows the file, doubling it so appends stay amortised O(1)
+    // The old mapping is only dropped once the new one is made, so if growing fails the log is as it was
+    // (the file may be left longer, which is harmless, as the header records the end)
+    bool reserve(std::uint64_t size) {
+        if(size <= capacity) {
+            return true;
+        }
+
+        std::uint64_t grown = std::max(size, capacity * 2);
+        unsigned char* mapping = map(grown);
+
+        if(!mapping) {
+            return false;
+        }
+
+        ::munmap(base, static_cast<std::size_t>(capacity));
+        base = mapping;
+        capacity = grown;
+        return true;
+    }
+
+    // Flushes, and trims the file back to its records so the next open starts appending there
+    // If the trim fails the spare space is harmless, as the header records the end
+    void close() {
+        if(base && options.write) {
+            flush();
+
+            std::uint64_t size = end();
+            ::munmap(base, static_cast<std::size_t>(capacity));
+            base = nullptr;
+
+            (void)::ftruncate(fd, static_cast<off_t>(size));
+        }
+
+        release();
+    }
+
+    void release() {
+        if(base) {
+            ::munmap(base, static_cast<std::size_t>(capacity));
+            base = nullptr;
+        }
+
+        if(fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    // Index file: the offset of each record as 64 bits
+    std::string index_path() const {
+        return path + ".idx";
+    }
+
+    // Takes the offsets from the index, as far as they agree with the log
+    void read_index() {
+        std::FILE* file = std::fopen(index_path().c_str(), "rb");
+
+        if(!file) {
+            return;
+        }
+
+        std::vector<std::uint64_t> index;
+        std::uint64_t block[4096];
+        std::size_t n;
+
+        while((n = std::fread(block, sizeof(std::uint64_t), 4096, file)) > 0) {
+            index.insert(index.end(), block, block + n);
+        }
+
+        std::fclose(file);
+        offsets.reserve(index.size());
+
+        for(std::uint64_t offset : index) {
+            if(!agrees(offset)) {
+                break;
+            }
+
+            add(offset, tag_at_offset(offset));
+        }
+
+        indexed = offsets.size();
+    }
+
+    void write_index() {
+        std::FILE* file = std::fopen(index_path().c_str(), "wb");
+
+        if(!file) {
+            return;
+        }
+
+        std::fwrite(offsets.data(), sizeof(std::uint64_t), offsets.size(), file);
+        std::fclose(file);
+        indexed = offsets.size();
+    }
+
+    // Whether an index entry can be the next record: it must have a valid tag, and the first
+    // must start after the header and each of the others where the one before ends
+    // With flat variants the size of a record follows from its tag. Other records
+    // are stepped over with Codec::skip, which reads string lengths rather than building them.
+    bool agrees(std::uint64_t offset) const {
+        if(offset + sizeof(Tag) > end()) {
+            return false;
+        }
+
+        std::size_t tag = tag_at_offset(offset);
+
+        if(tag >= sizeof...(Ts) || (flat && offset + flat_size(tag) > end())) {
+            return false;
+        }
+
+        if(offsets.empty()) {
+            return offset == sizeof(Header);
+        }
+
+        if(flat) {
+            return offset == offsets.back() + flat_size(tag_at(offsets.size() - 1));
+        }
+
+        ByteReader in = record(offsets.size() - 1);
+        return Codec<Enum>::skip(in) && static_cast<std::uint64_t>(in.position() - base) == offset;
+    }
+
+    // Size of a record with a valid tag, when the variants are flat
+    static std::uint64_t flat_size(std::size_t tag) {
+        return sizeof(Tag) + sizes[tag];
+    }
+
+    // Reads through the records after the last indexed one, checking each decodes
+    // If that fails, the index doesn't agree with the log after all, so it is dropped
+    // and the whole log is read through instead
+    bool scan() {
+        if(!offsets.empty()) {
+            ByteReader in = record(offsets.size() - 1);
+
+            if(decode<Enum>(in).has_value() && scan_from(static_cast<std::uint64_t>(in.position() - base))) {
+                return true;
+            }
+
+            offsets.clear();
+            for(auto& list : tags) {
+                list.clear();
+            }
+
+            indexed = 0;
+        }
+
+        return scan_from(sizeof(Header));
+    }
+
+    bool scan_from(std::uint64_t offset) {
+        while(offset < end()) {
+            ByteReader in(base + offset, static_cast<std::size_t>(end() - offset));
+            auto e = decode<Enum>(in);
+
+            if(!e.has_value()) {
+                return false;
+            }
+
+            add(offset, e->which());
+            offset = static_cast<std::uint64_t>(in.position() - base);
+        }
+
+        return true;
+    }
+
+    void add(std::uint64_t offset, std::size_t tag) {
+        if(options.tag_index) {
+            tags[tag].push_back(offsets.size());
+        }
+
+        offsets.push_back(offset);
+    }
+
+    Header& header() const {
+        return *reinterpret_cast<Header*>(base);
+    }
+
+    std::uint64_t end() const {
+        return header().end;
+    }
+
+    ByteReader record(std::size_t i) const {
+        return ByteReader(base + offsets[i], static_cast<std::size_t>(end() - offsets[i]));
+    }
+
+    std::size_t tag_at_offset(std::uint64_t offset) const {
+        Tag tag;
+        std::memcpy(&tag, base + offset, sizeof(Tag));
+        return tag;
+    }
+
+    std::size_t tag_at(std::size_t i) const {
+        return tag_at_offset(offsets[i]);
+    }
+
+    template<typename... Fs>
+    static bool visit(std::true_type, ByteReader in, Fs&... fs) {
+        auto view = EnumView<Enum>::read(in);
+
+        if(!view.has_value()) {
+            return false;
+        }
+
+        view->match(fs...);
+        return true;
+    }
+
+    template<typename... Fs>
+    static bool visit(std::false_type, ByteReader in, Fs&... fs) {
+        auto e = decode<Enum>(in);
+
+        if(!e.has_value()) {
+            return false;
+        }
+
+        e->match(fs...);
+        return true;
+    }
+
+    template<typename T, typename F>
+    bool visit_payload(std::size_t i, F& f) const {
+        ByteReader in = record(i);
+        in.skip(sizeof(Tag));
+
+        auto t = Serialize<T>::read(in);
+
+        if(!t.has_value()) {
+            return false;
+        }
+
+        f(*t);
+        return true;
+    }
+
+    std::string path;
+    LogOptions options;
+    int fd = -1;
+    unsigned char* base = nullptr;
+    std::uint64_t capacity = 0;
+
+    std::vector<std::uint64_t> offsets;
+    std::vector<std::vector<std::size_t>> tags;
+
+    // Records already in the index file
+    std::size_t indexed = 0;
+
+    Bytes scratch;
+};
+
+template<typename... Ts>
+constexpr char VariantLog<Ts...>::magic[8];
+
+template<typename... Ts>
+constexpr std::size_t VariantLog<Ts...>::sizes[];
+
+}
+
+#endif
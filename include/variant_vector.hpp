@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/variant_vector.hpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENUM_VARIANT_VECTOR_HPP
+#define ENUM_VARIANT_VECTOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "enum.hpp"
+
+namespace venum {
+
+// A sequence of EnumT<Ts...> values stored by alternative
+// Each alternative has its own dense array, so small ones aren't padded to the largest,
+// and a stream of tags (one byte each for up to 256 alternatives) remembers the order.
+// for_each_by_type runs each handler over its own array with no dispatch per element,
+// and for_each visits in the order the values were added.
+template<typename... Ts>
+class VariantVector {
+public:
+    using Enum = EnumT<Ts...>;
+    using TagT = SmallestTag<sizeof...(Ts)>;
+
+    static constexpr std::size_t variants = sizeof...(Ts);
+
+    // Add a T constructed in place
+    template<typename T, typename... Args>
+    T& emplace_back(Args&&... args) {
+        return emplace_back<IndexOf<T, Ts...>::value>(std::forward<Args>(args)...);
+    }
+
+    template<std::size_t n, typename... Args>
+    typename TypeList<Ts...>::template Nth<n>& emplace_back(Args&&... args) {
+        auto& array = std::get<n>(arrays);
+        array.emplace_back(std::forward<Args>(args)...);
+        tags.push_back(static_cast<TagT>(n));
+        return array.back();
+    }
+
+    // Add a value of one of the alternatives
+    template<typename T, typename = typename std::enable_if<!std::is_same<typename std::decay<T>::type, Enum>::value>::type>
+    void push_back(T&& t) {
+        emplace_back<typename std::decay<T>::type>(std::forward<T>(t));
+    }
+
+    // Add the value held by an enum
+    void push_back(const Enum& e) {
+        e.apply([this](const auto& t) { this->push_back(t); });
+    }
+
+    void push_back(Enum&& e) {
+        std::move(e).apply([this](auto&& t) { this->push_back(std::move(t)); });
+    }
+
+    std::size_t size() const noexcept {
+        return tags.size();
+    }
+
+    bool empty() const noexcept {
+        return tags.empty();
+    }
+
+    // Number of values of type T
+    template<typename T>
+    std::size_t count() const noexcept {
+        return values<T>().size();
+    }
+
+    // The values of type T, in the order they were added
+    template<typename T>
+    const std::vector<T>& values() const noexcept {
+        return std::get<IndexOf<T, Ts...>::value>(arrays);
+    }
+
+    template<typename T>
+    std::vector<T>& values() noexcept {
+        return std::get<IndexOf<T, Ts...>::value>(arrays);
+    }
+
+    // Reserve space for n values of type T
+    template<typename T>
+    void reserve(std::size_t n) {
+        values<T>().reserve(n);
+    }
+
+    void clear() noexcept {
+        tags.clear();
+        clear_arrays(std::index_sequence_for<Ts...>());
+    }
+
+    // Calls the handler for each alternative (in order of Ts) on every value of that type,
+    // one alternative after another, so each loop is over a single contiguous array
+    template<typename... Fs>
+    void for_each_by_type(Fs&&... fs) {
+        by_type(*this, std::index_sequence_for<Ts...>(), std::forward<Fs>(fs)...);
+    }
+
+    template<typename... Fs>
+    void for_each_by_type(Fs&&... fs) const {
+        by_type(*this, std::index_sequence_for<Ts...>(), std::forward<Fs>(fs)...);
+    }
+
+    // Calls the matching handler for every value, in the order they were added
+    template<typename... Fs>
+    void for_each(Fs&&... fs) {
+        in_order(*this, std::index_sequence_for<Ts...>(), std::forward_as_tuple(std::forward<Fs>(fs)...));
+    }
+
+    template<typename... Fs>
+    void for_each(Fs&&... fs) const {
+        in_order(*this, std::index_sequence_for<Ts...>(), std::forward_as_tuple(std::forward<Fs>(fs)...));
+    }
+
+private:
+    // Shared by the const and non-const visits, with V deduced as either
+    template<typename V, std::size_t... ns, typename... Fs>
+    static void by_type(V& v, std::index_sequence<ns...>, Fs&&... fs) {
+        static_assert(sizeof...(Fs) == variants, "for_each_by_type needs a handler for each alternative");
+
+        int expand[] = { (for_array(std::get<ns>(v.arrays), fs), 0)... };
+        (void)expand;
+    }
+
+    template<typename Array, typename F>
+    static void for_array(Array& array, F& f) {
+        for(auto& t : array) {
+            f(t);
+        }
+    }
+
+    // Dispatches on each tag through a table, with a cursor into each array
+    template<typename V, std::size_t... ns, typename Hs>
+    static void in_order(V& v, std::index_sequence<ns...>, Hs hs) {
+        static_assert(std::tuple_size<Hs>::value == variants, "for_each needs a handler for each alternative");
+
+        using Fn = void (*)(V&, std::size_t, Hs&);
+        static constexpr Fn table[] = { &visit_nth<ns, V, Hs>... };
+
+        std::array<std::size_t, variants> cursors = {};
+
+        for(TagT tag : v.tags) {
+            table[tag](v, cursors[tag]++, hs);
+        }
+    }
+
+    template<std::size_t n, typename V, typename Hs>
+    static void visit_nth(V& v, std::size_t i, Hs& hs) {
+        std::get<n>(hs)(std::get<n>(v.arrays)[i]);
+    }
+
+    template<std::size_t... ns>
+    void clear_arrays(std::index_sequence<ns...>) noexcept {
+        int expand[] = { (std::get<ns>(arrays).clear(), 0)... };
+        (void)expand;
+    }
+
+    std::tuple<std::vector<Ts>...> arrays;
+    std::vector<TagT> tags;
+};
+
+}
+
+#endif
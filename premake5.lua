@@ -4,12 +4,49 @@ workspace "Enum"
 project "test"
     kind "ConsoleApp"
     language "C++"
-    files { "include/**.hpp", "src/**.cpp" }
+    files { "include/**.hpp", "src/test.cpp" }
     includedirs { "include" }
     buildoptions { "--std=c++14" }
 
+    -- tree.hpp's parallel passes use std::thread, and AtomicEnum's 16 byte words need libatomic
+    filter { "system:linux" }
+        links { "pthread", "atomic" }
+
     filter { "configurations:Debug" }
         flags { "Symbols" }
 
     filter { "configurations:Release" }
         optimize "On"
+
+project "test_noexcept"
+    kind "ConsoleApp"
+    language "C++"
+    files { "include/**.hpp", "src/test_noexcept.cpp" }
+    includedirs { "include" }
+    buildoptions { "--std=c++14" }
+    exceptionhandling "Off"
+
+    filter { "configurations:Debug" }
+        flags { "Symbols" }
+
+    filter { "configurations:Release" }
+        optimize "On"
+
+-- Benchmarks that compare against std::variant need C++17
+local bench_std = { compare = "--std=c++17" }
+
+-- One benchmark executable per file in bench/
+for _, file in ipairs(os.matchfiles("bench/*.cpp")) do
+    local name = path.getbasename(file)
+
+    project("bench_" .. name)
+        kind "ConsoleApp"
+        language "C++"
+        files { "include/**.hpp", "bench/*.hpp", file }
+        includedirs { "include", "bench" }
+        buildoptions { bench_std[name] or "--std=c++14" }
+        optimize "On"
+
+        filter { "system:linux" }
+            links { "pthread", "atomic" }
+end
@@ -17,14 +17,100 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "enum.hpp"
+#include "atomic_enum.hpp"
+#include "box.hpp"
 #include "optional.hpp"
 #include "tree.hpp"
+#include "concurrent_tree.hpp"
+#include "message_queue.hpp"
+#include "persistent_tree.hpp"
+#include "serialize.hpp"
+#include "variant_log.hpp"
+#include "variant_vector.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
 #include <string>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Checks for behaviour the output alone doesn't show, failing the run if any fail
+static int failures = 0;
+
+void check(bool ok, const char* what) {
+    if(!ok) {
+        std::cout << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// Counts heap allocations, for checking that visiting does not copy
+// Atomic as the parallel tree test allocates from several threads
+// Every form is replaced, so everything allocated with malloc is freed with free
+static std::atomic<std::size_t> allocations(0);
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    ++allocations;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size) {
+    if(void* p = operator new(size, std::nothrow)) {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
 struct Thing {
     int i;
     char c;
@@ -80,8 +166,1322 @@ void exception_test() {
     );
 }
 
+struct CountingHandler {
+    static std::size_t copies;
+
+    CountingHandler() {}
+    CountingHandler(const CountingHandler&) { ++copies; }
+
+    void operator()(std::string& s) const { s[0] = 'y'; }
+    void operator()(const std::string& s) const {}
+    void operator()(std::vector<int>& v) const { v.clear(); }
+    void operator()(const std::vector<int>& v) const {}
+};
+
+std::size_t CountingHandler::copies = 0;
+
+void copy_test() {
+    using Test = venum::EnumT<std::string, std::vector<int>>;
+
+    Test test(std::string(64, 'x'));
+    const Test& ctest = test;
+    CountingHandler handler;
+
+    std::size_t before = allocations;
+
+    test.match(
+        [](std::string& s) { s[0] = 'z'; },
+        [](std::vector<int>& v) { v.clear(); }
+    );
+
+    ctest.match(
+        [](const std::string& s) {},
+        [](const std::vector<int>& v) {}
+    );
+
+    test.apply(handler);
+    ctest.apply(handler);
+    test.match(handler, handler);
+
+    std::cout << "allocations during visit: " << allocations - before << std::endl;
+    std::cout << "handler copies during visit: " << CountingHandler::copies << std::endl;
+
+    std::string moved = std::move(test).match(
+        [](std::string&& s) { return std::move(s); },
+        [](std::vector<int>&&) { return std::string(); }
+    );
+
+    std::cout << "moved out: " << moved.size() << std::endl;
+}
+
+struct WideTag : public venum::DefaultPolicy {
+    using Tag = std::uint32_t;
+};
+
+void size_test() {
+    using Small = venum::EnumT<int, char>;
+    using Wide = venum::BasicEnum<WideTag>::Variant<int>::Variant<char>;
+    using Padded = venum::EnumT<std::array<char, 5>, int>;
+
+    static_assert(std::is_same<Small::TagT, std::uint8_t>::value, "small enums should use a byte tag");
+    static_assert(std::is_same<Wide::TagT, std::uint32_t>::value, "policy should override the tag type");
+    static_assert(sizeof(Small) == 2 * sizeof(int), "tag should fit in the padding after an int");
+    static_assert(sizeof(Padded) == 2 * sizeof(int), "tag should fit in the padding after the storage");
+
+    std::cout << "sizeof(EnumT<int, char>): " << sizeof(Small) << std::endl;
+    std::cout << "sizeof(EnumT<std::array<char, 5>, int>): " << sizeof(Padded) << std::endl;
+    std::cout << "sizeof(EnumT<int, char>) with uint32_t tag: " << sizeof(Wide) << std::endl;
+}
+
+void trivial_test() {
+    using Trivial = venum::EnumT<int, float, Thing>;
+    using NonTrivial = venum::EnumT<int, std::string>;
+
+    static_assert(std::is_trivially_copyable<Trivial>::value, "enum of trivial variants should be trivially copyable");
+    static_assert(std::is_trivially_destructible<Trivial>::value, "enum of trivial variants should be trivially destructible");
+    static_assert(!std::is_trivially_copyable<NonTrivial>::value, "enum with a non-trivial variant should not be trivially copyable");
+    static_assert(!std::is_trivially_destructible<NonTrivial>::value, "enum with a non-trivial variant should not be trivially destructible");
+
+    Trivial a(Thing{5, 'a'});
+    Trivial b(2.5f);
+    b = a;
+
+    b.match(
+        [](int i) { std::cout << "int: " << i << std::endl; },
+        [](float f) { std::cout << "float: " << f << std::endl; },
+        [](Thing& t) { std::cout << "trivially copied thing: " << t.i << ", " << t.c << std::endl; }
+    );
+}
+
+void assign_test() {
+    using Test = venum::EnumT<int, std::string>;
+
+    Test a(std::string(64, 'a'));
+    Test b(std::string(32, 'b'));
+    const char* buffer = a.get<std::string>().data();
+
+    std::size_t before = allocations;
+    a = b;
+    std::cout << "allocations during same variant assignment: " << allocations - before << std::endl;
+    std::cout << "buffer reused: " << (a.get<std::string>().data() == buffer) << std::endl;
+
+    a = Test(5);
+    std::cout << "assigned different variant: " << a.get<int>() << std::endl;
+
+    a = b;
+    std::cout << "assigned back: " << a.get<std::string>() << std::endl;
+}
+
+struct Tracked {
+    static std::size_t moves;
+
+    int value;
+
+    Tracked(int value) : value(value) {}
+    Tracked(const Tracked& other) : value(other.value) { ++moves; }
+    Tracked(Tracked&& other) : value(other.value) { ++moves; }
+};
+
+std::size_t Tracked::moves = 0;
+
+void emplace_test() {
+    using Test = venum::EnumT<int, std::string, Tracked>;
+
+    auto test = Test::construct<Tracked>(3);
+    std::cout << "copies/moves during construct<T>: " << Tracked::moves << std::endl;
+
+    test.emplace<std::string>(5, 'e');
+    std::cout << "emplaced by type: " << test.get<std::string>() << std::endl;
+
+    test.emplace<2>(9);
+    std::cout << "emplaced by index: " << test.get<Tracked>().value << std::endl;
+    std::cout << "copies/moves during emplace: " << Tracked::moves << std::endl;
+
+    Test copy(test);
+    std::cout << "copied from non-const lvalue: " << copy.get<Tracked>().value << std::endl;
+}
+
+struct PairHandler {
+    template<typename A, typename B>
+    std::string operator()(A& a, B& b) {
+        std::ostringstream str;
+        str << a << ", " << b;
+        return str.str();
+    }
+
+    std::string operator()(const venum::InvalidVariantError& e) {
+        return e.what();
+    }
+};
+
+// Gives the reason if any enum is invalid, or -1
+struct ReasonHandler {
+    template<typename A, typename B>
+    int operator()(A&, B&) {
+        return -1;
+    }
+
+    int operator()(const venum::InvalidVariantError& e) {
+        return e.reason();
+    }
+};
+
+void multi_match_test() {
+    using A = venum::EnumT<int, std::string>;
+    using B = venum::EnumT<char, double>;
+
+    A a(std::string("a"));
+    B b(2.5);
+
+    std::cout << "pair: " << venum::match(PairHandler(), a, b) << std::endl;
+
+    venum::match(
+        [](auto& x, auto& y, const auto& z) { std::cout << "triple: " << x << ", " << y << ", " << z << std::endl; },
+        a, b, A(3)
+    );
+
+    // BadThing's move can throw, so a moved from C is invalid
+    using C = venum::EnumT<int, BadThing>;
+
+    C c(1);
+    C moved = std::move(c);
+
+    int valid = venum::match(ReasonHandler(), moved, b);
+    int reason = venum::match(ReasonHandler(), c, b);
+    int reversed = venum::match(ReasonHandler(), b, c);
+
+    bool threw = false;
+    try {
+        venum::match([](auto&, auto&) {}, c, b);
+    } catch(venum::InvalidVariantError& e) {
+        threw = e.reason() == venum::InvalidReason::MovedFrom;
+    }
+
+    std::cout << "pair with invalid: " << reason << ", reversed " << reversed << ", threw " << threw << std::endl;
+    check(!c.valid() && valid == -1 && reason == venum::InvalidReason::MovedFrom && reversed == reason && threw,
+        "match calls the error handler, or throws, when an enum is invalid");
+}
+
+void policy_test() {
+    using Test = venum::BasicEnum<venum::NoExceptionsPolicy>::Variant<int>::Variant<std::string>;
+
+    Test test(std::string("no exceptions"));
+
+    if(auto s = test.try_get<std::string>()) {
+        std::cout << "try_get: " << *s << std::endl;
+    }
+
+    std::cout << "try_get wrong type: " << (test.try_get<int>() == nullptr) << std::endl;
+}
+
+struct ThrowingCtor {
+    ThrowingCtor(int) { throw std::runtime_error("ctor"); }
+};
+
+void never_empty_test() {
+    using Test = venum::EnumT<int, std::string, ThrowingCtor>;
+    static_assert(Test::never_empty, "nothrow movable variants should never be empty");
+    static_assert(!venum::EnumT<BadThing, std::string>::never_empty, "throwing copy should allow invalid states");
+    static_assert(std::is_nothrow_move_constructible<Test>::value, "never empty move should be noexcept");
+
+    Test test(std::string("still here"));
+    Test moved(std::move(test));
+    std::cout << "moved from still valid: " << test.valid() << std::endl;
+    check(test.valid() && test.contains<std::string>() && moved.get<std::string>() == "still here", "moved from never empty enum keeps its variant");
+
+    // The moved from string is usable, and a throwing emplace leaves it alone
+    test.get<std::string>() = "reused";
+
+    bool threw = false;
+    try {
+        test.emplace<ThrowingCtor>(1);
+    } catch(std::runtime_error&) {
+        threw = true;
+    }
+
+    std::cout << "unchanged after emplace throw: " << test.get<std::string>() << std::endl;
+    check(threw && test.valid() && test.get<std::string>() == "reused", "never empty enum is unchanged by a throwing emplace");
+
+    // Without the fast path a throwing emplace invalidates the enum
+    static_assert(venum::InvalidReason::Unknown == 3 && venum::InvalidReason::EmplaceThrew == 4, "reasons keep their values");
+
+    venum::EnumT<BadThing, ThrowingCtor> invalidated(std::string("bad"));
+
+    try {
+        invalidated.emplace<ThrowingCtor>(1);
+    } catch(std::runtime_error&) {}
+
+    check(!invalidated.valid() && invalidated.reason() == venum::InvalidReason::EmplaceThrew, "throwing emplace invalidates the enum");
+}
+
+// An index where -1 means no index
+struct Index {
+    int i;
+};
+
+template<>
+struct NicheTraits<Index> {
+    static constexpr bool value = true;
+
+    static Index none() {
+        return Index{-1};
+    }
+
+    static bool is_none(const Index& index) {
+        return index.i == -1;
+    }
+};
+
+void niche_test() {
+    static_assert(sizeof(Optional<int*>) == sizeof(int*), "null pointer should be the niche");
+    static_assert(sizeof(Optional<std::shared_ptr<int>>) == sizeof(std::shared_ptr<int>), "null shared_ptr should be the niche");
+    static_assert(sizeof(Optional<std::unique_ptr<int>>) == sizeof(std::unique_ptr<int>), "null unique_ptr should be the niche");
+    static_assert(sizeof(Optional<Index>) == sizeof(Index), "user sentinel should be the niche");
+    static_assert(sizeof(Optional<int>) > sizeof(int), "int has no niche");
+
+    int x = 3;
+    auto some = Optional<int*>::Some(&x);
+    auto none = Optional<int*>::None();
+    std::cout << "niche some: " << *some.get() << ", none: " << static_cast<bool>(none) << std::endl;
+
+    auto index = Optional<Index>::Some(Index{4});
+    std::cout << "sentinel: " << index.map([](Index i) { return i.i * 2; }).get() 
+              << ", " << static_cast<bool>(Optional<Index>::None()) << std::endl;
+
+    // Matches like the tagged optional, trailing error handler included
+    int matched = some.match([](None) { return 0; }, [](int* p) { return *p; }, [](const venum::InvalidVariantError&) { return -1; });
+    check(matched == 3 && some.contains<int*>() && none.contains<None>(), "niche optional matches with an error handler");
+}
+
+void optional_move_test() {
+    auto o = Optional<std::string>::Some(std::string(64, 'a'));
+    std::cout << "has_value: " << o.has_value() << ", value: " << o->size() << std::endl;
+
+    allocations = 0;
+    std::string result = std::move(o)
+        .map([](std::string&& s) { s[0] = 'b'; return std::move(s); })
+        .and_then([](std::string&& s) { return Optional<std::string>::Some(std::move(s)); })
+        .value_or("none");
+    std::cout << "allocations in optional chain: " << allocations << ", " << result[0] << std::endl;
+
+    std::cout << "value_or on None: " << Optional<std::string>::None().value_or("fallback") << std::endl;
+
+    // Built in place, with and without a niche
+    int z = 0;
+    Optional<std::string> built(venum::InPlace<std::string>(), 3, 'x');
+    Optional<int*> pointer(venum::InPlace<int*>(), &z);
+    check(built.has_value() && *built == "xxx" && pointer.has_value() && *pointer == &z, "optional is built in place");
+}
+
+void balanced_tree_test() {
+    Tree<int> balanced;
+    Tree<int, Unbalanced> unbalanced;
+
+    for(int i = 0; i < 1000; ++i) {
+        balanced.insert(i);
+        unbalanced.insert(i);
+    }
+
+    std::cout << "sorted insert height: " << balanced.height() << " balanced, " << unbalanced.height() << " unbalanced" << std::endl;
+
+    for(int i = 0; i < 1000; i += 2) {
+        balanced.erase(i);
+    }
+
+    bool ok = !balanced.erase(0);
+    for(int i = 0; i < 1000; ++i) {
+        ok = ok && balanced.contains(i) == (i % 2 == 1);
+    }
+
+    int previous = -1;
+    balanced.apply([&](int i) { ok = ok && previous < i; previous = i; });
+
+    std::cout << "after erase: " << ok << ", height " << balanced.height() << std::endl;
+}
+
+// Counts live instances, for checking the arena runs destructors
+struct Live {
+    static int count;
+
+    int value;
+
+    Live(int value) : value(value) { ++count; }
+    Live(const Live& other) : value(other.value) { ++count; }
+    Live(Live&& other) : value(other.value) { ++count; }
+    Live& operator=(const Live&) = default;
+    Live& operator=(Live&&) = default;
+    ~Live() { --count; }
+
+    bool operator<(const Live& other) const { return value < other.value; }
+    bool operator==(const Live& other) const { return value == other.value; }
+};
+
+int Live::count = 0;
+
+void arena_tree_test() {
+    {
+        Tree<Live> tree;
+        for(int i = 0; i < 5000; ++i) {
+            tree.insert(Live(i));
+        }
+
+        for(int i = 0; i < 5000; i += 3) {
+            tree.erase(Live(i));
+        }
+
+        std::cout << "arena live after erase: " << Live::count << std::endl;
+
+        Tree<Live> moved(std::move(tree));
+        std::cout << "arena moved: " << moved.contains(Live(1)) << ", " << moved.contains(Live(3)) << std::endl;
+
+        moved.clear();
+        std::cout << "arena live after clear: " << Live::count << std::endl;
+
+        moved.insert(Live(7));
+    }
+
+    std::cout << "arena live after destruction: " << Live::count << std::endl;
+
+    Tree<int, AVL, SharedNodes> shared;
+    shared.insert(1);
+    shared.insert(2);
+    std::cout << "shared nodes: " << shared.contains(2) << std::endl;
+}
+
+void tree_iterator_test() {
+    Tree<int> tree;
+    for(int i = 0; i < 100; ++i) {
+        tree.insert((i * 37) % 100);
+    }
+
+    int previous = -1;
+    bool ordered = true;
+    for(int i : tree) {
+        ordered = ordered && previous + 1 == i;
+        previous = i;
+    }
+
+    auto last = tree.end();
+    --last;
+
+    std::cout << "iterated in order: " << ordered << ", size " << std::distance(tree.begin(), tree.end())
+              << ", last " << *last << ", found " << *std::find(tree.begin(), tree.end(), 42) << std::endl;
+
+    tree.erase(50);
+    auto range = tree.equal_range(50);
+    std::cout << "range [40, 60): " << std::distance(tree.lower_bound(40), tree.lower_bound(60))
+              << ", erased: " << (range.first == range.second) << ", next: " << *range.first << std::endl;
+
+    // Deep enough that recursion per level would be a problem
+    Tree<int, Unbalanced> degenerate;
+    for(int i = 0; i < 20000; ++i) {
+        degenerate.insert(i);
+    }
+
+    std::cout << "degenerate height: " << degenerate.height() << ", contains: " << degenerate.contains(19999) << std::endl;
+}
+
+// Copies trees deeply, and takes a long chain of shared nodes apart on a small stack,
+// where destroying it node by node through the links would overflow
+void tree_copy_test() {
+    Tree<int> tree;
+    for(int i = 0; i < 1000; ++i) {
+        tree.insert((i * 37) % 1000);
+    }
+
+    Tree<int> copy = tree;
+    copy.erase(500);
+
+    Tree<int> assigned;
+    assigned.insert(-1);
+    assigned = copy;
+
+    bool same = std::equal(tree.begin(), tree.end(), Tree<int>(tree).begin()) && tree.height() == copy.height();
+    std::cout << "tree copy: same " << same << ", independent " << (tree.contains(500) && !copy.contains(500))
+              << ", assigned " << (!assigned.contains(-1) && !assigned.contains(500) && assigned.contains(499)) << std::endl;
+    check(same && tree.contains(500) && !copy.contains(500) && !assigned.contains(-1) && std::distance(assigned.begin(), assigned.end()) == 999,
+        "tree copies are deep");
+
+    struct Chain {
+        Tree<int, Unbalanced, SharedNodes> tree;
+        bool copied = false;
+    } chain;
+
+    for(int i = 0; i < 20000; ++i) {
+        chain.tree.insert(i);
+    }
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, 1 << 18);
+
+    pthread_t thread;
+    pthread_create(&thread, &attributes, [](void* p) -> void* {
+        Chain& chain = *static_cast<Chain*>(p);
+
+        Tree<int, Unbalanced, SharedNodes> copy = chain.tree;
+        chain.copied = copy.height() == 20000 && copy.contains(19999);
+
+        chain.tree.clear();
+        return nullptr;
+    }, &chain);
+
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attributes);
+
+    std::cout << "shared chain on a small stack: copied " << chain.copied << ", cleared " << !chain.tree.contains(0) << std::endl;
+    check(chain.copied && !chain.tree.contains(0), "shared nodes are copied and freed without recursing");
+}
+
+void frozen_tree_test() {
+    std::vector<int> sorted;
+    for(int i = 0; i < 1000; ++i) {
+        sorted.push_back(i * 2);
+    }
+
+    auto tree = Tree<int>::build_from_sorted(sorted.begin(), sorted.end());
+    tree.erase(10);
+    tree.insert(11);
+
+    std::cout << "built height: " << tree.height() << ", in order: " << std::is_sorted(tree.begin(), tree.end())
+              << ", contains: " << tree.contains(998) << tree.contains(11) << tree.contains(10) << std::endl;
+
+    auto frozen = tree.freeze();
+    bool same = std::equal(frozen.begin(), frozen.end(), tree.begin());
+
+    bool bounds = true;
+    for(int i = -1; i < 2001; ++i) {
+        auto expected = tree.lower_bound(i);
+        auto found = frozen.lower_bound(i);
+        bounds = bounds && (expected == tree.end() ? found == frozen.end() : *found == *expected);
+        bounds = bounds && frozen.contains(i) == tree.contains(i);
+    }
+
+    std::cout << "frozen: " << frozen.size() << ", same order: " << same << ", same bounds: " << bounds << std::endl;
+}
+
+void parallel_tree_test() {
+    std::vector<int> values;
+    for(int i = 0; i < 100000; ++i) {
+        values.push_back((i * 7919) % 100000);
+    }
+
+    auto tree = Tree<int>::build_from_unsorted(values.begin(), values.end(), 4);
+    std::cout << "parallel build: " << std::is_sorted(tree.begin(), tree.end())
+              << ", " << std::distance(tree.begin(), tree.end()) << ", height " << tree.height() << std::endl;
+
+    std::atomic<long> sum(0);
+    tree.parallel_apply([&](int i) { sum += i; }, 4);
+
+    // Concatenating digits only gives the right string if the pieces are combined in order
+    auto digits = tree.parallel_reduce(std::string(), [](int i) { return std::to_string(i % 10); },
+        [](std::string lhs, const std::string& rhs) { return lhs + rhs; }, 4);
+
+    std::string expected;
+    tree.apply([&](int i) { expected += std::to_string(i % 10); });
+
+    std::cout << "parallel apply sum: " << sum << ", reduce in order: " << (digits == expected) << std::endl;
+
+    bool rethrown = false;
+    try {
+        tree.parallel_apply([](int i) {
+            if(i == 500) {
+                throw std::runtime_error("parallel failure");
+            }
+        }, 4);
+    } catch(std::runtime_error&) {
+        rethrown = true;
+    }
+
+    Tree<int> empty;
+    std::cout << "parallel rethrow: " << rethrown
+              << ", empty reduce: " << empty.parallel_reduce(7, [](int i) { return i; }, [](int a, int b) { return a + b; })
+              << std::endl;
+}
+
+// One writer inserts keys in order and then erases them in order, so every
+// snapshot a reader takes must be one run of consecutive keys
+void concurrent_tree_test() {
+    constexpr int keys = 20000;
+
+    ConcurrentTree<int> tree;
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::atomic<long> snapshots(0);
+
+    std::vector<std::thread> readers;
+    for(int r = 0; r < 4; ++r) {
+        readers.emplace_back([&]() {
+            while(!done) {
+                auto snapshot = tree.snapshot();
+
+                int expected = -1;
+                for(int i : snapshot) {
+                    if(expected != -1 && i != expected) {
+                        ++torn;
+                    }
+
+                    expected = i + 1;
+                }
+
+                // Between writes, what contains sees may only grow then shrink, never tear
+                if(expected > 0 && !snapshot.contains(expected - 1)) {
+                    ++torn;
+                }
+
+                ++snapshots;
+            }
+        });
+    }
+
+    for(int i = 0; i < keys; ++i) {
+        tree.insert(i);
+    }
+
+    int height = tree.height();
+    int erased = 0;
+
+    for(int i = 0; i < keys; ++i) {
+        erased += tree.erase(i) ? 1 : 0;
+    }
+
+    done = true;
+    for(auto& reader : readers) {
+        reader.join();
+    }
+
+    std::cout << "concurrent tree: height " << height << ", erased " << erased << ", torn snapshots " << torn
+              << ", empty after: " << !tree.contains(0) << (tree.height() == 0) << std::endl;
+
+    // Snapshots outlive later writes
+    tree.insert(1);
+    tree.insert(2);
+    auto before = tree.snapshot();
+    tree.erase(1);
+    tree.insert(3);
+    tree.clear();
+
+    std::vector<int> seen(before.begin(), before.end());
+    std::cout << "old snapshot: " << seen.size() << " " << before.contains(1) << before.contains(3) << std::endl;
+}
+
+void persistent_tree_test() {
+    PersistentTree<int> empty;
+    std::vector<PersistentTree<int>> versions(1, empty);
+
+    for(int i = 0; i < 1000; ++i) {
+        versions.push_back(versions.back().insert(i));
+    }
+
+    // Every version still holds exactly what it did when it was made
+    bool unchanged = true;
+    for(int i = 0; i <= 1000; i += 100) {
+        const auto& version = versions[i];
+        unchanged = unchanged && std::distance(version.begin(), version.end()) == i
+            && (i == 0 || version.contains(i - 1)) && !version.contains(i);
+    }
+
+    auto latest = versions.back();
+    auto snapshot = latest;
+    auto smaller = latest.erase(500).erase(0).erase(999);
+
+    std::cout << "persistent versions unchanged: " << unchanged << ", height " << latest.height()
+              << ", snapshot same: " << snapshot.same(latest) << ", missing erase same: " << latest.erase(5000).same(latest)
+              << std::endl;
+
+    std::cout << "persistent erase: " << std::distance(smaller.begin(), smaller.end())
+              << " " << smaller.contains(500) << snapshot.contains(500)
+              << ", in order: " << std::is_sorted(smaller.begin(), smaller.end()) << std::endl;
+}
+
+void variant_vector_test() {
+    struct Big {
+        std::array<int, 16> values;
+    };
+
+    venum::VariantVector<int, std::string, Big> vector;
+    vector.push_back(1);
+    vector.push_back(std::string("two"));
+    vector.emplace_back<Big>(Big{ { 3 } });
+    vector.push_back(venum::EnumT<int, std::string, Big>(4));
+    vector.push_back(std::string("five"));
+
+    std::cout << "variant vector: " << vector.size() << " values, "
+              << vector.count<int>() << vector.count<std::string>() << vector.count<Big>() << " by type" << std::endl;
+
+    std::ostringstream by_type;
+    vector.for_each_by_type(
+        [&](int& i) { by_type << i << " "; },
+        [&](std::string& s) { by_type << s << " "; },
+        [&](Big& b) { by_type << b.values[0] << " "; }
+    );
+
+    std::ostringstream in_order;
+    const auto& view = vector;
+    view.for_each(
+        [&](const int& i) { in_order << i << " "; },
+        [&](const std::string& s) { in_order << s << " "; },
+        [&](const Big& b) { in_order << b.values[0] << " "; }
+    );
+
+    std::cout << "by type: " << by_type.str() << "| in order: " << in_order.str() << std::endl;
+
+    vector.clear();
+    std::cout << "cleared: " << vector.empty() << vector.count<int>() << std::endl;
+}
+
+// Equal values of the same type, for comparing variants
+template<typename T>
+bool same_value(const T& a, const T& b) {
+    return a == b;
+}
+
+template<typename T, typename U>
+bool same_value(const T&, const U&) {
+    return false;
+}
+
+// Encodes random messages and decodes them back, then checks that decoding
+// cut short or corrupted input fails cleanly rather than reading out of bounds
+void serialize_test() {
+    struct Point {
+        float x, y;
+
+        bool operator==(const Point& other) const {
+            return x == other.x && y == other.y;
+        }
+    };
+
+    using Message = venum::EnumT<std::uint8_t, std::int64_t, Point, std::string>;
+    using Flat = venum::EnumT<std::uint8_t, std::int64_t, Point>;
+
+    std::mt19937 random(11);
+    std::vector<Message> messages;
+    venum::Bytes bytes;
+
+    for(int i = 0; i < 2000; ++i) {
+        switch(random() % 4) {
+            case 0: messages.emplace_back(venum::InPlaceIndex<0>(), static_cast<std::uint8_t>(random())); break;
+            case 1: messages.emplace_back(venum::InPlaceIndex<1>(), static_cast<std::int64_t>(random()) << 20); break;
+            case 2: messages.emplace_back(venum::InPlaceIndex<2>(), Point{ float(random() % 100), 0.5f }); break;
+            default: messages.emplace_back(venum::InPlaceIndex<3>(), std::string(random() % 20, 'x')); break;
+        }
+
+        venum::encode(messages.back(), bytes);
+    }
+
+    auto same = [](const Message& a, const Message& b) {
+        return a.which() == b.which() && venum::match([](const auto& x, const auto& y) {
+            return same_value(x, y);
+        }, a, b);
+    };
+
+    venum::ByteReader reader(bytes);
+    bool round_trip = true;
+    for(auto& message : messages) {
+        auto decoded = venum::decode<Message>(reader);
+        round_trip = round_trip && decoded.has_value() && same(*decoded, message);
+    }
+
+    std::cout << "serialize round trip: " << round_trip << ", all read: " << reader.done() << std::endl;
+    check(round_trip && reader.done(), "serialized enums decode to what was encoded");
+
+    // A bool is checked when it is read back, and enums and pointers aren't written raw
+    enum class Colour { Red, Green };
+    static_assert(venum::RawBytes<Point>::value && !venum::RawBytes<bool>::value && !venum::RawBytes<Colour>::value
+        && !venum::RawBytes<int*>::value, "only types with no invalid byte patterns are written raw");
+
+    using Flag = venum::EnumT<bool, int>;
+    venum::Bytes flag;
+    venum::encode(Flag(true), flag);
+
+    venum::ByteReader valid(flag);
+    bool flag_read = venum::decode<Flag>(valid)->get<bool>();
+
+    flag.back() = 2;
+    venum::ByteReader invalid(flag);
+    bool flag_refused = !venum::decode<Flag>(invalid).has_value();
+
+    check(flag_read && flag_refused, "bools decode only from 0 or 1");
+
+    // Corrupt or cut the buffer at random and decode whatever is left
+    std::size_t decoded = 0;
+    for(int i = 0; i < 2000; ++i) {
+        venum::Bytes corrupt(bytes.begin(), bytes.begin() + random() % bytes.size());
+        for(int flips = 0; flips < 4 && !corrupt.empty(); ++flips) {
+            corrupt[random() % corrupt.size()] = static_cast<unsigned char>(random());
+        }
+
+        venum::ByteReader in(corrupt);
+        while(venum::decode<Message>(in).has_value()) {
+            ++decoded;
+        }
+    }
+
+    // Views read the same values in place
+    venum::Bytes flat_bytes;
+    std::vector<Flat> flats;
+    for(int i = 0; i < 100; ++i) {
+        flats.push_back(i % 2 ? Flat(venum::InPlaceIndex<1>(), std::int64_t(i)) : Flat(Point{ float(i), 1 }));
+        venum::encode(flats.back(), flat_bytes);
+    }
+
+    venum::ByteReader view_reader(flat_bytes);
+    bool views = true;
+    for(auto& flat : flats) {
+        auto view = venum::EnumView<Flat>::read(view_reader);
+        views = views && view.has_value() && view->which() == flat.which()
+            && view->get().which() == flat.which()
+            && view->match([](std::uint8_t) { return 0.0; }, [](std::int64_t i) { return double(i); }, [](const Point& p) { return double(p.x); })
+                == flat.match([](std::uint8_t) { return 0.0; }, [](std::int64_t i) { return double(i); }, [](const Point& p) { return double(p.x); });
+    }
+
+    std::cout << "serialize fuzz survived (" << (decoded > 0) << "), views: " << views << ", view at end: "
+              << !venum::EnumView<Flat>::read(view_reader).has_value() << std::endl;
+}
+
+// Opens the log from variant_log_test with index files that don't agree with it,
+// which must be ignored from the first entry that doesn't
+void variant_log_index_test(const std::string& path) {
+    using Log = venum::VariantLog<std::int32_t, std::string, double>;
+
+    // Opening for writing reads through the log and writes the true index on closing
+    std::remove((path + ".idx").c_str());
+    Log::open(path);
+
+    std::vector<std::uint64_t> offsets(1001);
+    std::FILE* file = std::fopen((path + ".idx").c_str(), "rb");
+    check(file && std::fread(offsets.data(), sizeof(std::uint64_t), offsets.size(), file) == offsets.size(), "variant log writes its index");
+    std::fclose(file);
+
+    venum::LogOptions options;
+    options.write = false;
+    options.tag_index = true;
+
+    auto write_index = [&](const std::vector<std::uint64_t>& index) {
+        std::FILE* file = std::fopen((path + ".idx").c_str(), "wb");
+        std::fwrite(index.data(), sizeof(std::uint64_t), index.size(), file);
+        std::fclose(file);
+    };
+
+    auto reads_back = [&](const std::vector<std::uint64_t>& index) {
+        write_index(index);
+
+        auto log = Log::open(path, options);
+        if(!log.has_value() || log->size() != 1001 || log->count<std::string>() != 333 || log->count<std::int32_t>() != 335) {
+            return false;
+        }
+
+        bool decodes = true;
+        for(std::size_t i = 0; i < log->size(); ++i) {
+            decodes = decodes && log->at(i).has_value();
+        }
+
+        std::size_t visited = 0;
+        bool complete = log->for_each([&](std::int32_t) { ++visited; }, [&](const std::string&) { ++visited; }, [&](double) { ++visited; });
+
+        return decodes && complete && visited == 1001;
+    };
+
+    // Record 10 is the string "sss": its tag, then its length as 32 bits, then its characters
+    auto into_record = [&](std::size_t n) {
+        std::vector<std::uint64_t> index(offsets.begin(), offsets.begin() + 10);
+        index.push_back(offsets[10] + n);
+        index.insert(index.end(), offsets.begin() + 11, offsets.end());
+        return index;
+    };
+
+    bool agrees = reads_back(offsets);
+    bool bad_tag = reads_back(into_record(5));
+    bool valid_tag = reads_back(into_record(2));
+
+    std::vector<std::uint64_t> too_far = offsets;
+    too_far[500] = 1 << 30;
+
+    std::vector<std::uint64_t> missing = offsets;
+    missing.erase(missing.begin() + 10);
+
+    bool past_end = reads_back(too_far);
+    bool skipped = reads_back(missing);
+    bool unordered = reads_back(std::vector<std::uint64_t>(offsets.rbegin(), offsets.rend()));
+
+    std::cout << "variant log index: agrees " << agrees << ", bad tag " << bad_tag << ", tag inside a record " << valid_tag
+              << ", past the end " << past_end << ", missing a record " << skipped << ", unordered " << unordered << std::endl;
+    check(agrees && bad_tag && valid_tag && past_end && skipped && unordered, "variant log ignores index entries that don't agree with it");
+
+    std::remove((path + ".idx").c_str());
+}
+
+// Appends until the file can't grow, which must leave the log as it was
+void variant_log_grow_test() {
+    using Log = venum::VariantLog<std::int64_t>;
+    const std::string path = "variant_log_grow_test.log";
+
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    struct rlimit limit;
+    ::getrlimit(RLIMIT_FSIZE, &limit);
+
+    struct rlimit lower = limit;
+    lower.rlim_cur = 3 << 19;
+
+    auto handler = std::signal(SIGXFSZ, SIG_IGN);
+    ::setrlimit(RLIMIT_FSIZE, &lower);
+
+    std::int64_t appended = 0;
+    bool grew = false;
+
+    {
+        auto log = Log::open(path);
+        while(log->append(appended)) {
+            ++appended;
+        }
+
+        ::setrlimit(RLIMIT_FSIZE, &limit);
+        std::signal(SIGXFSZ, handler);
+
+        std::int64_t sum = 0;
+        bool complete = log->for_each([&](std::int64_t i) { sum += i; });
+        auto last = log->at(log->size() - 1);
+
+        check(log->size() == static_cast<std::size_t>(appended) && complete && sum == appended * (appended - 1) / 2
+            && last.has_value() && last->get<std::int64_t>() == appended - 1, "variant log is unchanged when it can't grow");
+
+        grew = log->append(appended);
+    }
+
+    auto log = Log::open(path);
+    std::cout << "variant log grow: stopped at " << appended << ", grew after " << grew << ", reopened with " << log->size() << std::endl;
+    check(appended > 0 && grew && log->size() == static_cast<std::size_t>(appended) + 1, "variant log grows once it can");
+
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+}
+
+// Writes a log, then reads it back with and without its index, and appends to it again
+void variant_log_test() {
+    using Log = venum::VariantLog<std::int32_t, std::string, double>;
+    const std::string path = "variant_log_test.log";
+
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    {
+        auto log = Log::open(path);
+        for(int i = 0; i < 1000; ++i) {
+            if(i % 3 == 0) {
+                log->append(Log::Enum(std::int32_t(i)));
+            } else if(i % 3 == 1) {
+                log->append(Log::Enum(std::string(i % 7, 's')));
+            } else {
+                log->append(Log::Enum(i * 0.5));
+            }
+        }
+    }
+
+    venum::LogOptions read_only;
+    read_only.write = false;
+    read_only.tag_index = true;
+
+    long sum = 0;
+    std::size_t strings = 0;
+    std::size_t size = 0;
+    bool ordered = true;
+
+    {
+        auto log = Log::open(path, read_only);
+        size = log->size();
+
+        int expected = 0;
+        log->for_each(
+            [&](std::int32_t i) { ordered = ordered && i == expected; expected += 3; },
+            [&](const std::string&) {},
+            [&](double) {}
+        );
+
+        log->for_each_of<std::int32_t>([&](std::int32_t i) { sum += i; });
+        strings = log->count<std::string>();
+
+        auto record = log->at(997);
+        ordered = ordered && record.has_value() && record->get<std::string>() == std::string(997 % 7, 's');
+    }
+
+    std::cout << "variant log: " << size << " records, ordered " << ordered
+              << ", int sum " << sum << ", strings " << strings << std::endl;
+    check(size == 1000 && ordered && sum == 166833 && strings == 333, "variant log reads back what was written");
+
+    // Without the index the records are found by reading through, and appending carries on from the end
+    std::remove((path + ".idx").c_str());
+
+    {
+        auto log = Log::open(path);
+        log->append(Log::Enum(std::int32_t(-1)));
+    }
+
+    auto log = Log::open(path, read_only);
+    auto last = log->at(1000);
+    std::cout << "reopened: " << log->size() << " records, last " << last->get<std::int32_t>()
+              << ", not a log: " << !Log::open("src/test.cpp", read_only).has_value() << std::endl;
+    check(log->size() == 1001 && last.has_value() && last->get<std::int32_t>() == -1, "variant log appends after reopening");
+
+    // A read only log refuses to append, even with space mapped after the records,
+    // as a log that wasn't trimmed before a crash has
+    struct stat st;
+    ::stat(path.c_str(), &st);
+    check(::truncate(path.c_str(), st.st_size + 4096) == 0, "variant log can be given spare space");
+
+    log = Log::open(path, read_only);
+    check(log.has_value() && !log->append(Log::Enum(std::int32_t(5))) && log->size() == 1001, "read only variant log refuses to append");
+
+    log = Log::open(path + ".missing", read_only);
+    std::cout << "missing: " << !log.has_value() << std::endl;
+    check(!log.has_value(), "missing variant log doesn't open");
+
+    variant_log_index_test(path);
+    variant_log_grow_test();
+
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+}
+
+struct Refuses {
+    Refuses() {
+        throw std::runtime_error("refused");
+    }
+};
+
+struct Sent {
+    int producer;
+    int n;
+};
+
+// Fills and drains a queue, then has several producers send to one consumer
+void message_queue_test() {
+    auto shared = std::make_shared<int>(0);
+
+    {
+        venum::MessageQueue<int, std::string, std::shared_ptr<int>, Refuses> queue(5);
+
+        int sent = 0;
+        while(queue.try_emplace<int>(sent)) {
+            ++sent;
+        }
+
+        int expected = 0;
+        bool ordered = true;
+        std::size_t first = queue.drain_at_most(3, [&](int i) { ordered = ordered && i == expected++; },
+            [](std::string&) {}, [](std::shared_ptr<int>&) {}, [](Refuses&) {});
+        std::size_t rest = queue.drain([&](int i) { ordered = ordered && i == expected++; },
+            [](std::string&) {}, [](std::shared_ptr<int>&) {}, [](Refuses&) {});
+
+        std::cout << "message queue: capacity " << queue.capacity() << ", sent " << sent << ", drained "
+                  << first << " + " << rest << ", ordered " << ordered << std::endl;
+        check(queue.capacity() == 8 && sent == 8 && first == 3 && rest == 5 && ordered, "message queue fills and drains in order");
+
+        // A message that fails to build is skipped, and the ones after it still arrive
+        bool threw = false;
+        try {
+            queue.try_emplace<Refuses>();
+        } catch(const std::runtime_error&) {
+            threw = true;
+        }
+
+        queue.emplace<std::string>(5, 'm');
+        queue.emplace<std::shared_ptr<int>>(shared);
+        queue.emplace<std::shared_ptr<int>>(shared);
+
+        std::string received;
+        queue.drain_at_most(2, [](int) {}, [&](std::string& s) { received = std::move(s); },
+            [](std::shared_ptr<int>&) {}, [](Refuses&) {});
+
+        std::cout << "threw " << threw << ", received " << received << ", references left " << shared.use_count() << std::endl;
+        check(threw && received == "mmmmm" && shared.use_count() == 2, "message queue skips a message that fails to build");
+    }
+
+    std::cout << "destroyed undrained: " << (shared.use_count() == 1) << std::endl;
+    check(shared.use_count() == 1, "message queue destroys undrained messages");
+
+    constexpr int producers = 4;
+    constexpr int messages = 50000;
+
+    venum::MessageQueue<Sent, std::string> queue(256);
+
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p]() {
+            for(int n = 0; n < messages; ++n) {
+                if(n % 100 == 0) {
+                    queue.emplace<std::string>(std::to_string(p));
+                } else {
+                    queue.emplace<Sent>(Sent{ p, n });
+                }
+            }
+        });
+    }
+
+    std::array<int, producers> last;
+    last.fill(-1);
+
+    int received = 0;
+    int strings = 0;
+    bool ordered = true;
+
+    while(received < producers * messages) {
+        std::size_t handled = queue.drain(
+            [&](Sent& s) { ordered = ordered && s.n > last[s.producer]; last[s.producer] = s.n; },
+            [&](std::string& s) { strings += s.size() == 1 ? 1 : 0; }
+        );
+
+        if(handled == 0) {
+            std::this_thread::yield();
+        }
+
+        received += static_cast<int>(handled);
+    }
+
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    std::cout << "message queue threads: received " << received << ", strings " << strings
+              << ", each producer in order " << ordered << ", empty after " << (queue.drain([](Sent&) {}, [](std::string&) {}) == 0) << std::endl;
+
+    bool all = true;
+    for(int l : last) {
+        all = all && l == messages - 1;
+    }
+
+    check(received == producers * messages && strings == producers * messages / 100 && ordered && all,
+        "message queue delivers every message from each producer in order");
+}
+
+struct Idle {};
+
+struct Running {
+    int progress;
+};
+
+struct Failed {
+    short code;
+};
+
+struct Both {
+    std::int32_t a;
+    std::int32_t b;
+};
+
+// Counts up through compare_exchange on several threads, and checks readers never see half a store
+void atomic_enum_test() {
+    using State = venum::EnumT<Idle, Running, Failed>;
+
+    venum::AtomicEnum<Idle, Running, Failed> state(State(Idle{}));
+
+    State expected(Running{ 0 });
+    bool stale = !state.compare_exchange(expected, State(Failed{ 1 }));
+    bool updated = expected.contains<Idle>() && state.compare_exchange(expected, State(Running{ 0 }));
+
+    constexpr int threads = 4;
+    constexpr int increments = 10000;
+
+    std::vector<std::thread> counters;
+    for(int t = 0; t < threads; ++t) {
+        counters.emplace_back([&state]() {
+            for(int i = 0; i < increments; ++i) {
+                State current = state.load();
+                while(!state.compare_exchange_weak(current, State(Running{ current.get<Running>().progress + 1 }))) {}
+            }
+        });
+    }
+
+    for(auto& counter : counters) {
+        counter.join();
+    }
+
+    State last = state.exchange(State(Failed{ 7 }));
+
+    std::cout << "atomic enum: " << sizeof(venum::AtomicEnum<Idle, Running, Failed>::Word) << " byte word, stale "
+              << stale << ", updated " << updated << ", counted " << last.get<Running>().progress
+              << ", failed with " << state.load().get<Failed>().code << std::endl;
+    check(stale && updated && last.get<Running>().progress == threads * increments && state.load().get<Failed>().code == 7,
+        "atomic enum counts every compare_exchange");
+
+    // Two words, written with both halves equal or as a tag on its own
+    using Pair = venum::EnumT<Idle, Both>;
+
+    venum::AtomicEnum<Idle, Both> pair(Pair(Both{ 0, 0 }));
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+
+    std::thread reader([&]() {
+        while(!done) {
+            pair.load().match(
+                [](const Idle&) {},
+                [&](const Both& b) { torn += b.a == b.b ? 0 : 1; }
+            );
+        }
+    });
+
+    for(std::int32_t i = 0; i < 100000; ++i) {
+        pair.store(i % 3 == 0 ? Pair(Idle{}) : Pair(Both{ i, i }));
+    }
+
+    done = true;
+    reader.join();
+
+    std::cout << "atomic enum pair: " << sizeof(venum::AtomicEnum<Idle, Both>::Word) << " byte word, torn " << torn << std::endl;
+    check(sizeof(venum::AtomicEnum<Idle, Running, Failed>::Word) == 8 && sizeof(venum::AtomicEnum<Idle, Both>::Word) == 16 && torn == 0,
+        "atomic enum readers never see half a store");
+}
+
+struct Large {
+    char bytes[512];
+};
+
+struct Add;
+struct Mul;
+
+using Expr = venum::EnumT<double, venum::Box<Add>, venum::Box<Mul>>;
+
+struct Add {
+    Expr lhs, rhs;
+};
+
+struct Mul {
+    Expr lhs, rhs;
+};
+
+double evaluate(const Expr& e) {
+    return e.match(
+        [](double d) { return d; },
+        [](const Add& a) { return evaluate(a.lhs) + evaluate(a.rhs); },
+        [](const Mul& m) { return evaluate(m.lhs) * evaluate(m.rhs); }
+    );
+}
+
+// Keeps large and recursive variants out of line, and checks the pool reuses their memory
+void box_test() {
+    using Message = venum::EnumT<int, venum::Box<Large>>;
+
+    Message m(Large{ { 'b' } });
+    char first = m.match([](int) { return ' '; }, [](Large& l) { return l.bytes[0]; });
+
+    std::cout << "boxed storage: " << Message::storage_size << " rather than " << sizeof(Large)
+              << ", handler sees " << first << std::endl;
+    check(Message::storage_size < sizeof(Large) && first == 'b', "boxed variant is stored out of line");
+
+    Expr e(Mul{ Expr(Add{ Expr(1.0), Expr(2.0) }), Expr(3.0) });
+    Expr copy = e;
+    copy.get<venum::Box<Mul>>()->rhs = Expr(4.0);
+
+    Expr moved = std::move(copy);
+    std::cout << "expression: " << evaluate(e) << ", changed copy " << evaluate(moved)
+              << ", moved from box empty: " << !copy.get<venum::Box<Mul>>() << std::endl;
+    check(evaluate(e) == 9.0 && evaluate(moved) == 12.0 && !copy.get<venum::Box<Mul>>(), "boxed copies are deep");
+
+    // A moved from box copies as empty, and matching it calls the policy's invalid
+    Expr empty_copy = copy;
+    Expr assigned(1.0);
+    assigned = copy;
+
+    auto moved_from = [](const Expr& e) {
+        try {
+            evaluate(e);
+        } catch(const venum::InvalidVariantError& error) {
+            return error.reason() == venum::InvalidReason::MovedFrom;
+        }
+
+        return false;
+    };
+
+    bool invalid = moved_from(copy) && moved_from(empty_copy) && moved_from(assigned);
+
+    // With an error handler, match passes it the empty box rather than throwing
+    int handled = copy.match(
+        [](double) { return -1; },
+        [](const Add&) { return -1; },
+        [](const Mul&) { return -1; },
+        [](const venum::InvalidVariantError& error) { return static_cast<int>(error.reason()); }
+    );
+
+    int both = venum::match(ReasonHandler(), e, copy);
+    check(handled == venum::InvalidReason::MovedFrom && both == handled && venum::match(ReasonHandler(), e, moved) == -1,
+        "match passes a moved from box to the error handler");
+
+    copy = e;
+    assigned = moved;
+    std::cout << "moved from box: copies empty " << !empty_copy.get<venum::Box<Mul>>() << ", match invalid " << invalid
+              << ", usable after assigning " << evaluate(copy) << std::endl;
+    check(!empty_copy.get<venum::Box<Mul>>() && invalid
+        && evaluate(copy) == 9.0 && evaluate(assigned) == 12.0, "moved from box copies as empty and is invalid to match");
+
+    // Once the pool has slots, boxes come from there rather than the heap
+    std::vector<Message> messages;
+    messages.reserve(1000);
+
+    for(int round = 0; round < 2; ++round) {
+        std::size_t before = allocations;
+
+        for(int i = 0; i < 1000; ++i) {
+            messages.emplace_back(Large{});
+        }
+
+        messages.clear();
+        std::cout << "round " << round << " heap allocations " << (allocations - before > 0 ? "some" : "none") << std::endl;
+        check(round == 0 || allocations == before, "boxes come from the pool once it has slots");
+    }
+
+    // Boxes made on one thread and freed on another
+    std::vector<Expr> made;
+    std::thread maker([&made]() {
+        for(int i = 0; i < 10000; ++i) {
+            made.emplace_back(Add{ Expr(double(i)), Expr(1.0) });
+        }
+    });
+
+    maker.join();
+
+    double sum = 0;
+    std::thread freer([&made, &sum]() {
+        for(auto& e : made) {
+            sum += evaluate(e);
+        }
+
+        made.clear();
+    });
+
+    freer.join();
+
+    std::cout << "boxes across threads: " << sum << std::endl;
+    check(sum == 10000.0 * 9999.0 / 2 + 10000.0, "boxes made on one thread evaluate and free on another");
+}
+
 int main(int argc, char* argv[]) {
     exception_test();
+    copy_test();
+    size_test();
+    trivial_test();
+    assign_test();
+    emplace_test();
+    multi_match_test();
+    policy_test();
+    never_empty_test();
+    niche_test();
+    optional_move_test();
+    balanced_tree_test();
+    arena_tree_test();
+    tree_iterator_test();
+    tree_copy_test();
+    frozen_tree_test();
+    parallel_tree_test();
+    concurrent_tree_test();
+    persistent_tree_test();
+    variant_vector_test();
+    serialize_test();
+    variant_log_test();
+    message_queue_test();
+    atomic_enum_test();
+    box_test();
 
     using Test = venum::Enum
         ::Variant<std::string>
@@ -190,4 +1590,6 @@ int main(int argc, char* argv[]) {
     std::cout << tree.contains(8) << std::endl;
 
     []() {}();
+
+    return failures == 0 ? 0 : 1;
 }
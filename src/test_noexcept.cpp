@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////////
+//  File: cpp-enum-variant/test_noexcept.cpp
+//////////////////////////////////////////////////////////////////////////////
+//  Copyright 2017 Samuel Sleight
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+// Built with exceptions disabled (-fno-exceptions)
+
+#include "enum.hpp"
+#include "optional.hpp"
+
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct Thing {
+    int i;
+    char c;
+};
+
+// Its move isn't noexcept, so an enum holding one can be left invalid
+struct Buffer {
+    std::string data;
+
+    Buffer(std::string data) : data(std::move(data)) {}
+    Buffer(const Buffer& other) = default;
+    Buffer(Buffer&& other) : data(std::move(other.data)) {}
+};
+
+static int failures = 0;
+
+void check(bool ok, const char* what) {
+    if(!ok) {
+        std::cout << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// Whether f aborts, run in a child process
+template<typename F>
+bool aborts(F f) {
+    std::cout.flush();
+
+    pid_t pid = ::fork();
+    if(pid == 0) {
+        f();
+        ::_exit(0);
+    }
+
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+int main(int argc, char* argv[]) {
+    using Test = venum::EnumT<std::string, int, Thing, Buffer>;
+
+    static_assert(!Test::Policy::exceptions, "default policy should not use exceptions when they are disabled");
+    static_assert(!Test::never_empty, "a variant with a throwing move should allow invalid states");
+
+    Test test(std::string("hello"));
+    test.emplace<Thing>(Thing{1, 'a'});
+    test = Test(5);
+
+    test.apply([](auto& a) { std::cout << "apply: " << sizeof(a) << std::endl; });
+
+    int* i = test.try_get<int>();
+    check(i && *i == 5 && test.try_get<std::string>() == nullptr, "try_get gives only the held variant");
+
+    Test other = std::move(test);
+    std::cout << "valid after move: " << test.valid() << ", reason: " << test.reason() << std::endl;
+    check(!test.valid() && test.reason() == venum::InvalidReason::MovedFrom && other.get<int>() == 5, "moved from enum is invalid");
+
+    int reason = test.match(
+        [](std::string&) { return -1; },
+        [](int&) { return -1; },
+        [](Thing&) { return -1; },
+        [](Buffer&) { return -1; },
+        [](const venum::InvalidVariantError& e) { return static_cast<int>(e.reason()); }
+    );
+
+    check(reason == venum::InvalidReason::MovedFrom, "match calls the error handler on an invalid enum");
+
+    // Without an error handler the policy aborts
+    using Strict = venum::BasicEnum<venum::NoExceptionsPolicy>::Variant<int>::Variant<Buffer>;
+
+    Strict strict(3);
+    Strict strict_moved = std::move(strict);
+
+    check(aborts([&]() { test.apply([](auto&) {}); }), "apply on an invalid enum aborts");
+    check(aborts([&]() { other.get<std::string>(); }), "get of the wrong variant aborts");
+    check(aborts([&]() { strict.apply([](auto&) {}); }), "NoExceptionsPolicy::invalid aborts");
+    check(aborts([&]() { strict_moved.get<Buffer>(); }), "NoExceptionsPolicy::bad_access aborts");
+    check(!aborts([&]() { strict_moved.get<int>(); }), "get of the held variant doesn't abort");
+
+    auto o = Optional<int>::Some(3);
+    std::cout << "optional value: " << o.value() << ", or: " << Optional<int>::None().value_or(4) << std::endl;
+    check(o.value() == 3 && aborts([]() { Optional<int>::None().value(); }), "Optional::value aborts on None");
+
+    return failures == 0 ? 0 : 1;
+}